@@ -0,0 +1,91 @@
+#ifndef ALLOC_COUNTER_HPP
+#define ALLOC_COUNTER_HPP
+
+// Counting malloc interposer to check hot paths for heap allocations. It also
+// covers operator new and Eigen's aligned allocations, which both end up in
+// malloc. The interposing functions are defined here and forward to glibc, so
+// include this header in exactly one translation unit of an executable.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *p);
+void *memalign(size_t alignment, size_t size) throw();
+}
+
+namespace alloc_counter {
+
+inline std::atomic<unsigned long> & count() {
+    static std::atomic<unsigned long> n(0);
+    return n;
+}
+
+inline void add() {
+    count().fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief allocations number of heap allocations since program start
+ */
+inline unsigned long allocations() {
+    return count().load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief The Scope class
+ * Counts the allocations between construction and the call of allocations().
+ */
+class Scope {
+private:
+    const unsigned long _start;
+public:
+    Scope() : _start(alloc_counter::allocations()) { }
+    unsigned long allocations() const { return alloc_counter::allocations() - _start; }
+};
+
+}
+
+extern "C" {
+
+void *malloc(size_t size) throw() {
+    alloc_counter::add();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) throw() {
+    alloc_counter::add();
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size) throw() {
+    alloc_counter::add();
+    return __libc_realloc(p, size);
+}
+
+void *memalign(size_t alignment, size_t size) throw() {
+    alloc_counter::add();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) throw() {
+    return memalign(alignment, size);
+}
+
+int posix_memalign(void **p, size_t alignment, size_t size) throw() {
+    *p = memalign(alignment, size);
+    return (*p==NULL) ? 12 /* ENOMEM */ : 0;
+}
+
+void free(void *p) throw() {
+    __libc_free(p);
+}
+
+}
+
+#endif // ALLOC_COUNTER_HPP
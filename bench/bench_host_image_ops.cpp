@@ -0,0 +1,135 @@
+// Microbenchmark of the host debug visualisation: the scalar per-pixel loops of
+// DebugObsDepth, DebugPredictedDepth and the host heat map vs. dart::host kernels.
+// Prints the time per frame and the largest difference of a color channel.
+
+#include <host_image_ops.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct Vertex { float x, y, z, w; };
+
+inline uchar3 color(const unsigned char x, const unsigned char y, const unsigned char z) {
+    uchar3 c;
+    c.x = x; c.y = y; c.z = z;
+    return c;
+}
+
+// loop of DebugObsDepth in track_manipulation
+void obsDepthScalar(uchar3 *img, const unsigned short *depth, const int size, const float scaleToMeters) {
+    static const float depthMin = 0.3;
+    static const float depthMax = 1.0;
+    for (int i=0; i<size; ++i) {
+        if (depth[i] == 0) {
+            img[i] = color(128,0,0);
+        } else {
+            unsigned char g = std::max(0,std::min((int)(255*(depth[i]*scaleToMeters-depthMin)/(float)(depthMax - depthMin)),255));
+            img[i] = color(g,g,g);
+        }
+    }
+}
+
+// loop of DebugPredictedDepth in track_manipulation
+void predDepthScalar(uchar3 *img, const Vertex *vertMap, const int size) {
+    static const float depthMin = 0.3;
+    static const float depthMax = 1.0;
+    for (int i=0; i<size; ++i) {
+        const float depth = vertMap[i].z;
+        if (depth == 0) {
+            img[i] = color(128,0,0);
+        } else {
+            unsigned char g = std::max(0,std::min((int)(255*(depth-depthMin)/(float)(depthMax - depthMin)),255));
+            img[i] = color(g,g,g);
+        }
+    }
+}
+
+// heat map of the host compute backend
+void heatMapScalar(uchar3 *img, const float *values, const int size, const float min, const float max) {
+    static const float ramp[5][3] = {{0,0,255}, {0,255,255}, {0,255,0}, {255,255,0}, {255,0,0}};
+    for (int i=0; i<size; ++i) {
+        const float v = values[i];
+        if(!(v>=min && v<=max)) {
+            img[i] = color(0,0,0);
+            continue;
+        }
+        const float s = (v-min)/(max-min)*4;
+        const int r = std::min(int(s), 3);
+        const float f = s-r;
+        img[i] = color(ramp[r][0] + f*(ramp[r+1][0]-ramp[r][0]),
+                       ramp[r][1] + f*(ramp[r+1][1]-ramp[r][1]),
+                       ramp[r][2] + f*(ramp[r+1][2]-ramp[r][2]));
+    }
+}
+
+template<typename F>
+double msPerCall(F f, const int iterations) {
+    // warm up
+    for(int i=0; i<iterations/10+1; i++) f();
+    const auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<iterations; i++) f();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end-start).count() / iterations;
+}
+
+int maxDifference(const std::vector<uchar3> &a, const std::vector<uchar3> &b) {
+    int diff = 0;
+    for(size_t i=0; i<a.size(); i++) {
+        diff = std::max(diff, std::abs(a[i].x-b[i].x));
+        diff = std::max(diff, std::abs(a[i].y-b[i].y));
+        diff = std::max(diff, std::abs(a[i].z-b[i].z));
+    }
+    return diff;
+}
+
+void report(const char *name, const int width, const int height, const double t_ref, const double t_host, const int diff) {
+    std::printf("%-16s %5dx%-5d %12.3f %12.3f %9.2fx %8d\n", name, width, height, t_ref, t_host, t_ref/t_host, diff);
+}
+
+int main(int argc, char *argv[]) {
+    // image sizes of the Xtion and the MultiSense stream
+    const int sizes[][2] = {{640, 480}, {1024, 1024}};
+    const int iterations = (argc>1) ? std::atoi(argv[1]) : 100;
+    const uchar3 invalid = color(128,0,0);
+
+    std::printf("%-16s %11s %12s %12s %10s %8s\n", "kernel", "image", "scalar [ms]", "host [ms]", "speedup", "max diff");
+
+    std::mt19937 rng(0);
+    for(const auto &s : sizes) {
+        const int width = s[0], height = s[1];
+        const int size = width*height;
+
+        // depth in mm between 0.2 and 1.2 m with 10% invalid pixels
+        std::vector<unsigned short> depth(size);
+        std::vector<Vertex> vertMap(size);
+        std::vector<float> errors(size);
+        std::uniform_real_distribution<float> uniform(0, 1);
+        for(int i=0; i<size; i++) {
+            const bool valid = uniform(rng)>0.1f;
+            depth[i] = valid ? (unsigned short)(200 + 1000*uniform(rng)) : 0;
+            vertMap[i].z = valid ? 0.2f + uniform(rng) : 0;
+            errors[i] = uniform(rng)*0.06f - 0.005f;
+        }
+
+        std::vector<uchar3> ref(size), img(size);
+
+        const double t_obs_ref = msPerCall([&]{ obsDepthScalar(ref.data(), depth.data(), size, 0.001f); }, iterations);
+        const double t_obs = msPerCall([&]{ dart::host::depthToGray(img.data(), depth.data(), size, 0.001f, 0.3f, 1.0f, invalid); }, iterations);
+        report("obs depth", width, height, t_obs_ref, t_obs, maxDifference(ref, img));
+
+        const double t_pred_ref = msPerCall([&]{ predDepthScalar(ref.data(), vertMap.data(), size); }, iterations);
+        const double t_pred = msPerCall([&]{ dart::host::depthToGray(img.data(), &vertMap[0].z, size, 1.0f, 0.3f, 1.0f, invalid, 4); }, iterations);
+        report("predicted depth", width, height, t_pred_ref, t_pred, maxDifference(ref, img));
+
+        const double t_heat_ref = msPerCall([&]{ heatMapScalar(ref.data(), errors.data(), size, 0, 0.05f); }, iterations);
+        const double t_heat = msPerCall([&]{ dart::host::heatMap(img.data(), errors.data(), size, 0, 0.05f); }, iterations);
+        report("heat map", width, height, t_heat_ref, t_heat, maxDifference(ref, img));
+    }
+
+    return 0;
+}
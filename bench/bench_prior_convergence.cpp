@@ -0,0 +1,210 @@
+// Convergence benchmark of the reported joints prior on a fixed synthetic replay:
+// Gauss-Newton iterations per frame until the estimate reaches the optimum of the
+// combined data and prior objective, for the previous rank-1 prior block and the
+// full-rank residual formulation of WeightedL2NormOfError.
+
+#include <priors.hpp>
+
+#include <Eigen/SparseCholesky>
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// DART adds this to the diagonal of the full system, see opts.regularization
+const float regularization = 0.01;
+// stop if the estimate is this close to the optimum of the frame
+const float tolerance = 1e-4;
+const int maxIterations = 100;
+const int frames = 200;
+const double weight = 1;
+
+/**
+ * @brief The Replay struct
+ * Synthetic replay of a single articulated model with 6 transformation parameters.
+ * The data term is a quadratic with well constrained transformation and weakly
+ * constrained joints, e.g. joints that are partially occluded in the depth image.
+ */
+struct Replay {
+    int joints;
+    Eigen::MatrixXf H;                      // data term J^T*J
+    std::vector<Eigen::VectorXf> observed;  // minimum of data term per frame
+    std::vector<Eigen::VectorXf> reported;  // reported joints per frame
+
+    Replay(const int n, const unsigned int seed) : joints(n) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<float> noise(0, 1);
+        const int dims = 6+n;
+
+        // random orthogonal basis with eigenvalues spread over two decades, the prior
+        // weight is in the order of the smallest eigenvalue
+        Eigen::MatrixXf A(dims, dims);
+        for(int i=0; i<A.size(); i++) A.data()[i] = noise(rng);
+        const Eigen::HouseholderQR<Eigen::MatrixXf> qr(A);
+        const Eigen::MatrixXf V = qr.householderQ();
+        Eigen::VectorXf ev(dims);
+        for(int i=0; i<dims; i++) ev[i] = std::pow(10.0f, 2.0f-2.0f*i/(dims-1));
+        H = V*ev.asDiagonal()*V.transpose();
+        H.topLeftCorner(6,6) += 100*Eigen::MatrixXf::Identity(6,6);
+
+        for(int f=0; f<frames; f++) {
+            Eigen::VectorXf truth(dims);
+            for(int i=0; i<dims; i++) truth[i] = 0.5f*std::sin(0.05f*f*(1+0.1f*i) + i);
+            Eigen::VectorXf obs(dims), rep(n);
+            for(int i=0; i<dims; i++) obs[i] = truth[i] + 0.02f*noise(rng);
+            for(int i=0; i<n; i++) rep[i] = truth[6+i] + 0.01f*noise(rng);
+            observed.push_back(obs);
+            reported.push_back(rep);
+        }
+    }
+};
+
+/**
+ * @brief The LegacyPrior class
+ * Previous formulation of WeightedL2NormOfError with a Jacobian column of the
+ * scalar error, of which J^T*J only adds to the first joint.
+ */
+class LegacyPrior : public dart::Prior {
+private:
+    const dart::Pose &_reported;
+    const dart::Pose &_estimated;
+    const float _weight;
+
+public:
+    LegacyPrior(const dart::Pose &reported, const dart::Pose &current, const float weight)
+        : _reported(reported), _estimated(current), _weight(weight) {}
+
+    void computeContribution(Eigen::SparseMatrix<float> & fullJTJ,
+                             Eigen::VectorXf & fullJTe,
+                             const int * modelOffsets,
+                             const int priorParamOffset,
+                             const std::vector<dart::MirroredModel *> & models,
+                             const std::vector<dart::Pose> & poses,
+                             const dart::OptimizationOptions & opts)
+    {
+        const int n = _estimated.getReducedArticulatedDimensions();
+        const Eigen::Map<const Eigen::VectorXf> est(_estimated.getReducedArticulation(), n);
+        const Eigen::Map<const Eigen::VectorXf> rep(_reported.getReducedArticulation(), n);
+        const Eigen::VectorXf diff = rep - est;
+        const float norm = diff.norm();
+        const float e = _weight * norm;
+        const Eigen::VectorXf J = (diff.array()==0).select(0, -_weight * diff.array()/norm).matrix();
+        const Eigen::MatrixXf JTJ = J.transpose()*J;
+        const int offset = modelOffsets[0]+6;
+        for(int r=0; r<JTJ.rows(); r++)
+            for(int c=0; c<JTJ.cols(); c++)
+                fullJTJ.coeffRef(offset+r, offset+c) += JTJ(r,c);
+        fullJTe.segment(offset, n) += J*e;
+    }
+};
+
+struct Result {
+    double iterations;  // mean over converged frames
+    int max_iterations;
+    int failed;         // frames that diverged or did not converge within maxIterations
+    double error;       // mean distance to optimum over converged frames
+};
+
+// run Gauss-Newton on all frames, each frame starts at the estimate of the previous frame
+template<typename MakePrior>
+Result run(const Replay &replay, MakePrior makePrior) {
+    const int n = replay.joints;
+    const int dims = 6+n;
+
+    std::vector<std::string> names;
+    std::vector<float> lower(n, -10), upper(n, 10);
+    for(int i=0; i<n; i++) names.push_back("joint_"+std::to_string(i));
+    dart::Pose estimated(new dart::NullReduction(n, lower.data(), upper.data(), names.data()));
+    dart::Pose reported(new dart::NullReduction(n, lower.data(), upper.data(), names.data()));
+    for(int i=0; i<n; i++) estimated.getReducedArticulation()[i] = 0;
+
+    dart::Prior *prior = makePrior(reported, estimated);
+
+    Eigen::VectorXf x = Eigen::VectorXf::Zero(dims);
+    const int modelOffset = 0;
+    std::vector<dart::MirroredModel *> models;
+    std::vector<dart::Pose> poses;
+    dart::OptimizationOptions opts;
+
+    const Eigen::MatrixXf Hreg = replay.H + regularization*Eigen::MatrixXf::Identity(dims, dims);
+    const Eigen::SparseMatrix<float> Hsparse = replay.H.sparseView();
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<float> > solver;
+
+    Result result = {0, 0, 0, 0};
+    for(int f=0; f<frames; f++) {
+        const Eigen::VectorXf &obs = replay.observed[f];
+        const Eigen::VectorXf &rep = replay.reported[f];
+        for(int i=0; i<n; i++) reported.getReducedArticulation()[i] = rep[i];
+
+        // optimum of the quadratic data and prior objective
+        Eigen::MatrixXf Hopt = replay.H;
+        Hopt.bottomRightCorner(n,n) += weight*weight*Eigen::MatrixXf::Identity(n,n);
+        Eigen::VectorXf bopt = replay.H*obs;
+        bopt.tail(n) += weight*weight*rep;
+        const Eigen::VectorXf optimum = Hopt.ldlt().solve(bopt);
+
+        const float tol = tolerance*(1+optimum.norm());
+        float error = (x-optimum).norm();
+        int it = 0;
+        while(it<maxIterations && !(error<=tol)) {
+            for(int i=0; i<n; i++) estimated.getReducedArticulation()[i] = x[6+i];
+
+            Eigen::SparseMatrix<float> JTJ = Hreg.sparseView();
+            JTJ.makeCompressed();
+            Eigen::VectorXf JTe = Hsparse*(x-obs);
+            prior->computeContribution(JTJ, JTe, &modelOffset, 0, models, poses, opts);
+
+            solver.compute(JTJ);
+            x -= solver.solve(JTe);
+            error = (x-optimum).norm();
+            it++;
+
+            if(!std::isfinite(error))
+                break;
+        }
+
+        result.max_iterations = std::max(result.max_iterations, it);
+        if(error<=tol) {
+            result.iterations += it;
+            result.error += error;
+        }
+        else {
+            // diverged or not converged, reset tracking to the optimum
+            result.failed++;
+            x = optimum;
+        }
+    }
+    const int converged = frames-result.failed;
+    result.iterations = converged>0 ? result.iterations/converged : NAN;
+    result.error = converged>0 ? result.error/converged : NAN;
+
+    delete prior;
+    return result;
+}
+
+int main() {
+    const int joints[] = {7, 16, 32};
+
+    std::printf("%6s | %-34s | %-34s\n", "", "rank-1 (legacy)", "full-rank");
+    std::printf("%6s | %8s %6s %6s %10s | %8s %6s %6s %10s\n", "joints",
+                "mean it", "max", "failed", "error", "mean it", "max", "failed", "error");
+
+    for(const int n : joints) {
+        const Replay replay(n, 42);
+
+        const Result legacy = run(replay, [](const dart::Pose &rep, const dart::Pose &est) -> dart::Prior * {
+            return new LegacyPrior(rep, est, weight);
+        });
+        const Result full = run(replay, [](const dart::Pose &rep, const dart::Pose &est) -> dart::Prior * {
+            return new dart::WeightedL2NormOfError(0, rep, est, weight);
+        });
+
+        std::printf("%6d | %8.2f %6d %6d %10.2e | %8.2f %6d %6d %10.2e\n", n,
+                    legacy.iterations, legacy.max_iterations, legacy.failed, legacy.error,
+                    full.iterations, full.max_iterations, full.failed, full.error);
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Microbenchmark of scattering a dense prior block into the sparse full JTJ:
+// per-coefficient coeffRef() vs. SparseBlockAccumulator::addBlock().
+// With --check, the exit status is non-zero if the scatter allocates in steady state.
+
+#include "alloc_counter.hpp"
+
+#include <sparse_block.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// model layout of the full system: a single articulated model followed by a rigid object
+Eigen::SparseMatrix<float> fullSystem(const int nJoints) {
+    const int modelDims = 6+nJoints;
+    const int objDims = 6;
+    const int dims = modelDims+objDims;
+
+    std::vector<Eigen::Triplet<float> > triplets;
+    // parameters within a model are densely coupled
+    for(int c=0; c<modelDims; c++)
+        for(int r=0; r<modelDims; r++)
+            triplets.push_back(Eigen::Triplet<float>(r, c, 1));
+    for(int c=modelDims; c<dims; c++)
+        for(int r=modelDims; r<dims; r++)
+            triplets.push_back(Eigen::Triplet<float>(r, c, 1));
+
+    Eigen::SparseMatrix<float> M(dims, dims);
+    M.setFromTriplets(triplets.begin(), triplets.end());
+    M.makeCompressed();
+    return M;
+}
+
+void scatterCoeffRef(Eigen::SparseMatrix<float> &M, const int offset, const Eigen::MatrixXf &B) {
+    for(unsigned int r=0; r<B.rows(); r++)
+        for(unsigned int c=0; c<B.cols(); c++)
+            if(B(r,c)!=0)
+                M.coeffRef(offset+r, offset+c) += B(r,c);
+}
+
+template<typename F>
+double allocsPerCall(F f, const int iterations) {
+    alloc_counter::Scope scope;
+    for(int i=0; i<iterations; i++) f();
+    return double(scope.allocations()) / iterations;
+}
+
+template<typename F>
+double nsPerCall(F f, const int iterations) {
+    // warm up
+    for(int i=0; i<iterations/10+1; i++) f();
+    const auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<iterations; i++) f();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end-start).count() / iterations;
+}
+
+int main(int argc, char *argv[]) {
+    bool check = false;
+    for(int i=1; i<argc; i++) {
+        if(std::strcmp(argv[i], "--check")==0)
+            check = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--check]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const int joints[] = {10, 40, 100};
+
+    bool allocates = false;
+    std::printf("%8s %10s %16s %16s %10s %12s\n", "joints", "block", "coeffRef [ns]", "addBlock [ns]", "speedup", "allocs/call");
+
+    for(const int n : joints) {
+        const int iterations = 2000000 / (n*n) + 100;
+        const int offset = 6;
+
+        Eigen::SparseMatrix<float> M = fullSystem(n);
+        dart::SparseBlockAccumulator acc;
+
+        // dense block, e.g. full weight matrix Q
+        const Eigen::MatrixXf dense = Eigen::MatrixXf::Random(n, n);
+        const double t_dense_ref = nsPerCall([&]{ scatterCoeffRef(M, offset, dense); }, iterations);
+        const double t_dense_acc = nsPerCall([&]{ acc.addBlock(M, offset, offset, dense); }, iterations);
+        const double a_dense = allocsPerCall([&]{ acc.addBlock(M, offset, offset, dense); }, 100);
+        std::printf("%8d %10s %16.1f %16.1f %9.2fx %12.2f\n", n, "dense", t_dense_ref, t_dense_acc, t_dense_ref/t_dense_acc, a_dense);
+
+        // diagonal block, e.g. scalar or per joint weights
+        const Eigen::MatrixXf diag = Eigen::VectorXf::Random(n).asDiagonal();
+        const Eigen::VectorXf d = diag.diagonal();
+        const double t_diag_ref = nsPerCall([&]{ scatterCoeffRef(M, offset, diag); }, iterations);
+        const double t_diag_acc = nsPerCall([&]{ acc.addDiagonal(M, offset, d); }, iterations);
+        const double a_diag = allocsPerCall([&]{ acc.addDiagonal(M, offset, d); }, 100);
+        std::printf("%8d %10s %16.1f %16.1f %9.2fx %12.2f\n", n, "diagonal", t_diag_ref, t_diag_acc, t_diag_ref/t_diag_acc, a_diag);
+
+        allocates |= (a_dense>0 || a_diag>0);
+    }
+
+    if(check && allocates) {
+        std::fprintf(stderr, "check failed: scatter allocates in steady state\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Benchmark of computeContribution() of all priors on synthetic articulated poses
+// without GPU. Reports time, heap allocations and cache misses per call.
+// With --check, the exit status is non-zero if any prior allocates in steady state.
+
+#include "alloc_counter.hpp"
+#include "perf_counter.hpp"
+
+#include <priors.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// synthetic pose with named joints and limits, like nullReductionPose() of a model
+dart::Pose syntheticPose(const int joints) {
+    std::vector<float> jointMins(joints, -3.14f), jointMaxs(joints, 3.14f);
+    std::vector<std::string> jointNames;
+    for(int j=0; j<joints; j++)
+        jointNames.push_back("joint_"+std::to_string(j));
+    return dart::Pose(new dart::NullReduction(joints, jointMins.data(), jointMaxs.data(), jointNames.data()));
+}
+
+// full system of the tracker: an articulated model followed by a rigid object,
+// parameters within a model are densely coupled by the data term
+Eigen::SparseMatrix<float> fullSystem(const int joints) {
+    const int modelDims = 6+joints;
+    const int dims = modelDims+6;
+
+    std::vector<Eigen::Triplet<float> > triplets;
+    for(int c=0; c<modelDims; c++)
+        for(int r=0; r<modelDims; r++)
+            triplets.push_back(Eigen::Triplet<float>(r, c, (r==c) ? modelDims : 0.01f));
+    for(int c=modelDims; c<dims; c++)
+        for(int r=modelDims; r<dims; r++)
+            triplets.push_back(Eigen::Triplet<float>(r, c, (r==c) ? 6 : 0.01f));
+
+    Eigen::SparseMatrix<float> M(dims, dims);
+    M.setFromTriplets(triplets.begin(), triplets.end());
+    M.makeCompressed();
+    return M;
+}
+
+// block-diagonal weights per group of 4 joints, e.g. fingers
+Eigen::SparseMatrix<float> groupWeights(const int joints) {
+    std::vector<Eigen::Triplet<float> > triplets;
+    for(int g=0; g<joints; g+=4)
+        for(int c=g; c<std::min(g+4, joints); c++)
+            for(int r=g; r<std::min(g+4, joints); r++)
+                triplets.push_back(Eigen::Triplet<float>(r, c, (r==c) ? 1 : 0.1f));
+    Eigen::SparseMatrix<float> Q(joints, joints);
+    Q.setFromTriplets(triplets.begin(), triplets.end());
+    return Q;
+}
+
+struct Measurement {
+    double ns;
+    double allocs;
+    double misses;  // negative if not available
+};
+
+Measurement measure(dart::Prior &prior, const int joints, const int iterations) {
+    Eigen::SparseMatrix<float> JTJ = fullSystem(joints);
+    Eigen::VectorXf JTe = Eigen::VectorXf::Zero(JTJ.rows());
+    const int modelOffsets[] = {0, 6+joints};
+    const std::vector<dart::MirroredModel *> models;
+    const std::vector<dart::Pose> poses;
+    const dart::OptimizationOptions opts;
+
+    const auto call = [&]{ prior.computeContribution(JTJ, JTe, modelOffsets, 0, models, poses, opts); };
+
+    // warm up, e.g. workspace and joint mapping are set up at first call
+    for(int i=0; i<iterations/10+1; i++) call();
+
+    Measurement m;
+
+    const auto start = std::chrono::steady_clock::now();
+    for(int i=0; i<iterations; i++) call();
+    const auto end = std::chrono::steady_clock::now();
+    m.ns = std::chrono::duration<double, std::nano>(end-start).count() / iterations;
+
+    {
+        alloc_counter::Scope scope;
+        for(int i=0; i<100; i++) call();
+        m.allocs = scope.allocations() / 100.0;
+    }
+
+    PerfCounter misses(PERF_COUNT_HW_CACHE_MISSES);
+    misses.start();
+    for(int i=0; i<iterations; i++) call();
+    const uint64_t n_misses = misses.stop();
+    m.misses = misses.valid() ? double(n_misses) / iterations : -1;
+
+    return m;
+}
+
+int main(int argc, char *argv[]) {
+    bool check = false;
+    for(int i=1; i<argc; i++) {
+        if(std::strcmp(argv[i], "--check")==0)
+            check = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--check]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const int joints[] = {6, 12, 24, 50, 100, 200};
+    const int modelID = 0;
+    const float scale = 0.1f;
+
+    std::printf("%-28s %6s %12s %12s %12s\n", "prior", "joints", "ns/call", "allocs/call", "misses/call");
+
+    bool allocates = false;
+    for(const int n : joints) {
+        dart::Pose estimated = syntheticPose(n);
+        dart::Pose reported = syntheticPose(n);
+        for(int j=0; j<n; j++) {
+            estimated.getReducedArticulation()[j] = 0.01f*j;
+            reported.getReducedArticulation()[j] = 0.02f*j - 0.5f;
+        }
+        const Eigen::SparseMatrix<float> Q = groupWeights(n);
+
+        std::vector<std::pair<std::string, std::unique_ptr<dart::Prior> > > priors;
+        priors.emplace_back("NoCameraMovementPrior", std::unique_ptr<dart::Prior>(new dart::NoCameraMovementPrior(modelID)));
+        priors.emplace_back("WeightedL2NormOfError", std::unique_ptr<dart::Prior>(new dart::WeightedL2NormOfError(modelID, reported, estimated, 1.0)));
+        priors.emplace_back("L2NormOfWeightedError", std::unique_ptr<dart::Prior>(new dart::L2NormOfWeightedError(modelID, reported, estimated, Q)));
+        priors.emplace_back("QWeightedError", std::unique_ptr<dart::Prior>(new dart::QWeightedError(modelID, reported, estimated, Q)));
+        priors.emplace_back("SimpleWeightedError", std::unique_ptr<dart::Prior>(new dart::SimpleWeightedError(modelID, reported, estimated, 1.0)));
+        priors.emplace_back("HuberWeightedError", std::unique_ptr<dart::Prior>(new dart::HuberWeightedError(modelID, reported, estimated, Q, scale)));
+        priors.emplace_back("CauchyWeightedError", std::unique_ptr<dart::Prior>(new dart::CauchyWeightedError(modelID, reported, estimated, Q, scale)));
+        priors.emplace_back("TukeyWeightedError", std::unique_ptr<dart::Prior>(new dart::TukeyWeightedError(modelID, reported, estimated, Q, scale)));
+
+        const int iterations = 2000000 / (n*n) + 1000;
+        for(auto &prior : priors) {
+            const Measurement m = measure(*prior.second, n, iterations);
+            allocates |= (m.allocs>0);
+            if(m.misses<0)
+                std::printf("%-28s %6d %12.1f %12.2f %12s\n", prior.first.c_str(), n, m.ns, m.allocs, "n/a");
+            else
+                std::printf("%-28s %6d %12.1f %12.2f %12.2f\n", prior.first.c_str(), n, m.ns, m.allocs, m.misses);
+        }
+    }
+
+    if(check && allocates) {
+        std::fprintf(stderr, "check failed: prior allocates in steady state\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef PERF_COUNTER_HPP
+#define PERF_COUNTER_HPP
+
+// Hardware event counter of the calling thread via perf_event_open(2). If the
+// kernel does not permit counting (e.g. perf_event_paranoid or a virtual machine
+// without PMU), the counter is invalid and reads 0.
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+
+class PerfCounter {
+private:
+    int _fd;
+
+public:
+    /**
+     * @brief PerfCounter open counter for a hardware event, disabled until start()
+     * @param config hardware event, e.g. PERF_COUNT_HW_CACHE_MISSES
+     */
+    explicit PerfCounter(const uint64_t config = PERF_COUNT_HW_CACHE_MISSES) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = syscall(__NR_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */, -1, 0);
+    }
+
+    ~PerfCounter() {
+        if(valid())
+            close(_fd);
+    }
+
+    PerfCounter(const PerfCounter &) = delete;
+    PerfCounter & operator=(const PerfCounter &) = delete;
+
+    bool valid() const { return _fd>=0; }
+
+    void start() {
+        if(!valid()) return;
+        ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    /**
+     * @brief stop stop counting
+     * @return number of events since start()
+     */
+    uint64_t stop() {
+        if(!valid()) return 0;
+        ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t count = 0;
+        if(read(_fd, &count, sizeof(count))!=sizeof(count))
+            return 0;
+        return count;
+    }
+};
+
+#endif // PERF_COUNTER_HPP
@@ -0,0 +1,86 @@
+#ifndef COLLISION_CLOUD_BATCH_HPP
+#define COLLISION_CLOUD_BATCH_HPP
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+#include <dart/geometry/SE3.h>
+
+namespace dart {
+
+/**
+ * @brief The CollisionCloudBatch class
+ * Collision clouds of all models transformed to the camera frame and drawn with a
+ * single draw call. The points of each model are grouped by their SDF frame once and
+ * stored as separate x, y and z arrays. Each frame, only one transform per SDF frame
+ * is composed, and the points of a group are transformed 4 at a time with SSE into
+ * homogeneous vertices, which are uploaded to a VBO.
+ *
+ * Groups are padded to a multiple of 4 points with copies of their last point, so the
+ * padding is drawn on top of an existing point.
+ */
+class CollisionCloudBatch {
+private:
+    struct Group {
+        int frame;
+        size_t begin;
+        size_t size;
+    };
+
+    struct ModelCloud {
+        ModelCloud() : vertex_offset(0), valid(false) { }
+
+        std::vector<Group> groups;
+        std::vector<float> x, y, z;
+        size_t vertex_offset;
+        bool valid;
+    };
+
+    std::vector<ModelCloud> _models;
+    std::vector<float4> _vertices;
+    GLuint _vbo;
+    size_t _vbo_capacity;
+    bool _uploaded;
+
+    CollisionCloudBatch(const CollisionCloudBatch&);
+    CollisionCloudBatch & operator=(const CollisionCloudBatch&);
+
+public:
+    /**
+     * @brief CollisionCloudBatch create VBO in the current GL context
+     */
+    CollisionCloudBatch();
+
+    ~CollisionCloudBatch();
+
+    /**
+     * @brief hasModel collision cloud of model was set
+     */
+    bool hasModel(const int model) const { return model < (int)_models.size() && _models[model].valid; }
+
+    /**
+     * @brief setModel group collision cloud of model by SDF frame
+     * @param cloud points in the frame of their SDF, with the SDF index in w
+     * @param sdf_frames SDF frame of each SDF of the model
+     */
+    void setModel(const int model, const float4 *cloud, const int size, const std::vector<int> &sdf_frames);
+
+    /**
+     * @brief transform transform collision cloud of model to the camera frame
+     * @param frame_to_camera transform of each SDF frame of the model to the camera frame
+     */
+    void transform(const int model, const std::vector<SE3> &frame_to_camera);
+
+    size_t size() const { return _vertices.size(); }
+
+    /**
+     * @brief draw draw transformed collision clouds of all models with GL_POINTS
+     */
+    void draw();
+};
+
+}
+
+#endif // COLLISION_CLOUD_BATCH_HPP
@@ -0,0 +1,86 @@
+#ifndef COMPUTE_BACKEND_HPP
+#define COMPUTE_BACKEND_HPP
+
+#include <cstddef>
+
+#ifdef CUDA_BUILD
+#include <vector_types.h>
+#else
+#include <dart/util/vector_type_template.h>
+#endif
+
+namespace dart {
+
+/**
+ * Device operations of the tracking application. With CUDA_BUILD, these run on
+ * the GPU (src/compute_backend_cuda.cpp), otherwise they run on the host with
+ * OpenMP threads (src/compute_backend_cpu.cpp). Pointers named "device" refer
+ * to device memory with CUDA and to host memory otherwise, like the device
+ * pointers of dart::MirroredVector and dart::Tracker.
+ */
+namespace backend {
+
+/**
+ * @brief initialise select and reset GPU, or set up worker threads on the host
+ * @param device CUDA device index, ignored for host builds
+ */
+void initialise(const int device = 0);
+
+/**
+ * @brief name human readable name of the backend, e.g. for logging
+ */
+const char * name();
+
+/**
+ * @brief deviceAlloc allocate device memory, aligned to at least 64 bytes
+ * @return NULL if the memory cannot be allocated
+ */
+void * deviceAlloc(const size_t bytes);
+
+/**
+ * @brief deviceFree free memory of deviceAlloc
+ */
+void deviceFree(void *ptr);
+
+/**
+ * @brief copyToHost copy device memory to host memory
+ * @param dst host destination
+ * @param src device source
+ * @param bytes number of bytes
+ */
+void copyToHost(void *dst, const void *src, const size_t bytes);
+
+/**
+ * @brief colorRampHeatMap color values in [min,max] by a heat map, values outside are black
+ * @param img device output image
+ * @param values device input values
+ */
+void colorRampHeatMap(uchar3 *img, const float *values, const int width, const int height, const float min, const float max);
+
+/**
+ * @brief colorSquaredRampHeatMap color squared values in [min,max] by a heat map
+ * @param img device output image
+ * @param values device input values, e.g. signed distance errors
+ * @param scratch device memory of width*height floats for the intermediate squared image
+ */
+void colorSquaredRampHeatMap(uchar3 *img, const float *values, const int width, const int height, const float min, const float max, float *scratch);
+
+/**
+ * @brief colorDataAssociation color pixels by the SDF colors of the associated model
+ * @param img device output image
+ * @param association device data association of tracker, -1 for unassociated pixels
+ * @param sdfColors device array of per-model device SDF colors
+ */
+void colorDataAssociation(uchar3 *img, const int *association, const uchar3 * const *sdfColors, const int width, const int height);
+
+/**
+ * @brief checkLastError print and reset the last asynchronous error
+ * @return true if there was no error
+ */
+bool checkLastError();
+
+}
+
+}
+
+#endif // COMPUTE_BACKEND_HPP
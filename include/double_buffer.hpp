@@ -0,0 +1,62 @@
+#ifndef DOUBLE_BUFFER_HPP
+#define DOUBLE_BUFFER_HPP
+
+#include <mutex>
+#include <utility>
+
+namespace dart {
+
+/**
+ * @brief The DoubleBuffer class
+ * Exchanges the latest state of a producer thread with a consumer thread. The producer
+ * fills the back buffer and publishes it by swapping it with the front buffer. The consumer
+ * takes the front buffer by swapping it with its own copy, which then becomes the next back
+ * buffer. Swaps only exchange the contents (e.g. vector storage) of T under a short lock,
+ * no data is copied and the buffers are reused without allocations.
+ * Intermediate states are dropped if the consumer is slower than the producer.
+ */
+template<typename T>
+class DoubleBuffer {
+private:
+    T _back;
+    T _front;
+    bool _fresh;
+    std::mutex _mutex;
+
+public:
+    DoubleBuffer() : _fresh(false) { }
+
+    /**
+     * @brief back buffer to be filled by the producer before calling publish()
+     */
+    T & back() { return _back; }
+
+    /**
+     * @brief publish make back buffer available to the consumer
+     */
+    void publish() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        using std::swap;
+        swap(_back, _front);
+        _fresh = true;
+    }
+
+    /**
+     * @brief acquire take the latest published state
+     * @param state consumer copy, replaced by the latest state if a new state was published
+     * @return true if state was replaced
+     */
+    bool acquire(T &state) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_fresh)
+            return false;
+        using std::swap;
+        swap(_front, state);
+        _fresh = false;
+        return true;
+    }
+};
+
+}
+
+#endif // DOUBLE_BUFFER_HPP
@@ -0,0 +1,96 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The FrameArena class
+ * Scratch memory of one frame on the host and the device, e.g. for intermediate
+ * debug images. Both regions are allocated once and memory is handed out by
+ * bumping an offset, everything is released at once by endFrame(). Thus a frame
+ * loop that only takes its scratch memory from the arena makes no allocator calls.
+ *
+ * If a region is too small, the request is served by a separate allocation that is
+ * freed at the end of the frame, and a warning is printed once. The reported peak
+ * usage includes these allocations, i.e. it is the size the region should have.
+ */
+class FrameArena {
+private:
+    struct Region {
+        Region() : base(NULL), capacity(0), used(0), frame_peak(0), peak(0), overflows(0), warned(false) { }
+
+        unsigned char *base;
+        size_t capacity;
+        size_t used;
+        size_t frame_peak;
+        size_t peak;
+        size_t overflows;
+        bool warned;
+        std::vector<void *> overflow;
+    };
+
+    Region _host;
+    Region _device;
+
+    FrameArena(const FrameArena&);
+    FrameArena & operator=(const FrameArena&);
+
+    void * allocate(Region &region, const size_t bytes, const bool device);
+    void release(Region &region, const bool device);
+
+public:
+    static const size_t Alignment = 64;
+
+    /**
+     * @brief FrameArena allocate scratch regions
+     * @param host_bytes size of host region
+     * @param device_bytes size of device region
+     */
+    FrameArena(const size_t host_bytes, const size_t device_bytes);
+
+    ~FrameArena();
+
+    /**
+     * @brief host scratch memory for n elements of T in host memory, valid until endFrame()
+     */
+    template<typename T>
+    T * host(const size_t n) { return static_cast<T*>(allocate(_host, n*sizeof(T), false)); }
+
+    /**
+     * @brief device scratch memory for n elements of T in device memory, valid until endFrame()
+     */
+    template<typename T>
+    T * device(const size_t n) { return static_cast<T*>(allocate(_device, n*sizeof(T), true)); }
+
+    /**
+     * @brief endFrame release all scratch memory of the frame
+     */
+    void endFrame();
+
+    /**
+     * @brief hostFramePeak bytes of host scratch memory used by the last finished frame
+     */
+    size_t hostFramePeak() const { return _host.frame_peak; }
+    size_t deviceFramePeak() const { return _device.frame_peak; }
+
+    /**
+     * @brief hostPeak largest use of host scratch memory of all frames
+     */
+    size_t hostPeak() const { return _host.peak; }
+    size_t devicePeak() const { return _device.peak; }
+
+    size_t hostCapacity() const { return _host.capacity; }
+    size_t deviceCapacity() const { return _device.capacity; }
+
+    /**
+     * @brief overflows number of requests served outside of the regions
+     */
+    size_t overflows() const { return _host.overflows + _device.overflows; }
+};
+
+}
+
+#endif // FRAME_ARENA_HPP
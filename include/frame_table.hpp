@@ -0,0 +1,130 @@
+#ifndef FRAME_TABLE_HPP
+#define FRAME_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dart {
+
+/**
+ * @brief The FrameTableHeader struct
+ * Header of the binary frame table format: a fixed number of values per frame,
+ * e.g. reported joint angles or contacts, stored frame by frame with a constant
+ * stride and optional timestamps per frame. All values are little-endian.
+ *
+ * layout: header | padding | timestamps (int64 per frame, optional) | padding | frames
+ * Sections start at multiples of 64 bytes, so that a mapped file can be used in place.
+ */
+struct FrameTableHeader {
+    enum ValueType {
+        Float32 = 0,
+        Int32 = 1
+    };
+
+    char magic[4];              // "DFTB"
+    uint32_t version;
+    uint32_t type;              // ValueType
+    uint32_t columns;           // values per frame
+    uint64_t frames;
+    uint64_t stride;            // bytes from one frame to the next
+    uint64_t timestamps_offset; // byte offset of timestamps in microseconds, 0 if not available
+    uint64_t data_offset;       // byte offset of first frame
+};
+
+/**
+ * @brief The StridedView class
+ * Read-only view of frames of T with a constant stride, e.g. into a mapped frame table.
+ * The view does not own the memory.
+ */
+template<typename T>
+class StridedView {
+private:
+    const unsigned char *_data;
+    size_t _frames;
+    int _columns;
+    size_t _stride;
+
+public:
+    StridedView() : _data(NULL), _frames(0), _columns(0), _stride(0) { }
+
+    StridedView(const void *data, const size_t frames, const int columns, const size_t stride)
+        : _data(static_cast<const unsigned char*>(data)), _frames(frames), _columns(columns), _stride(stride) { }
+
+    /**
+     * @brief operator [] values of frame
+     */
+    const T * operator[](const size_t frame) const { return reinterpret_cast<const T*>(_data + frame*_stride); }
+
+    size_t size() const { return _frames; }
+    bool empty() const { return _frames==0; }
+    int columns() const { return _columns; }
+};
+
+/**
+ * @brief The MappedFrameTable class
+ * Binary frame table mapped read-only into memory. Opening only validates the header,
+ * pages of the frames are loaded by the OS when they are accessed.
+ */
+class MappedFrameTable {
+private:
+    void *_map;
+    size_t _size;
+    const FrameTableHeader *_header;
+
+    MappedFrameTable(const MappedFrameTable&);
+    MappedFrameTable & operator=(const MappedFrameTable&);
+
+public:
+    MappedFrameTable();
+    ~MappedFrameTable();
+
+    /**
+     * @brief open map binary frame table
+     * @return false if file cannot be mapped or is not a valid frame table
+     */
+    bool open(const std::string &file);
+
+    void close();
+
+    bool isOpen() const { return _header!=NULL; }
+
+    size_t frames() const { return _header ? _header->frames : 0; }
+    int columns() const { return _header ? _header->columns : 0; }
+
+    /**
+     * @brief timestamps timestamp of each frame in microseconds, NULL if the table has none
+     */
+    const int64_t * timestamps() const;
+
+    /**
+     * @brief floats view of a table of Float32 values, empty for other types
+     */
+    StridedView<float> floats() const;
+
+    /**
+     * @brief ints view of a table of Int32 values, empty for other types
+     */
+    StridedView<int> ints() const;
+};
+
+/**
+ * @brief convertFrameTableText convert text table to binary frame table
+ * The text table contains the number of frames, the number of values per frame unless
+ * given by columns, and the values of all frames, separated by whitespace. This is the
+ * format of the reported joint angles ("frames joints values...") and contacts
+ * ("frames values...", 10 per frame) of the demo sequences.
+ * @param text_file input text table
+ * @param binary_file output binary frame table
+ * @param type type of values
+ * @param columns values per frame, read from the text file if 0
+ * @param timestamp_file optional text file with one timestamp in microseconds per frame
+ * @return false if input cannot be parsed or output cannot be written
+ */
+bool convertFrameTableText(const std::string &text_file, const std::string &binary_file,
+                           const FrameTableHeader::ValueType type, const int columns = 0,
+                           const std::string &timestamp_file = "");
+
+}
+
+#endif // FRAME_TABLE_HPP
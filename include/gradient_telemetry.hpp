@@ -0,0 +1,161 @@
+#ifndef GRADIENT_TELEMETRY_HPP
+#define GRADIENT_TELEMETRY_HPP
+
+#include <dart/tracker.h>
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <lcmtypes/bot_core/joint_angles_t.hpp>
+
+namespace dart {
+
+/**
+ * @brief The GradientSink class
+ * Transport for gradient samples. Sinks are only called from the telemetry thread.
+ */
+class GradientSink {
+public:
+    virtual ~GradientSink() { }
+
+    /**
+     * @brief publish publish a single gradient sample
+     * @param utime timestamp of sample in microseconds
+     * @param names joint names
+     * @param values gradient values in order of names
+     */
+    virtual void publish(const int64_t utime, const std::vector<std::string> &names, const std::vector<float> &values) = 0;
+};
+
+/**
+ * @brief The LCMGradientSink class
+ * Publish gradients as bot_core::joint_angles_t on an LCM channel.
+ */
+class LCMGradientSink : public GradientSink {
+private:
+    const std::string _channel;
+    bot_core::joint_angles_t _msg;
+
+public:
+    LCMGradientSink(const std::string &channel = "DART_GRADIENT");
+
+    void publish(const int64_t utime, const std::vector<std::string> &names, const std::vector<float> &values);
+};
+
+/**
+ * @brief The FileGradientSink class
+ * Write gradients as CSV, one sample per line, with a header of joint names.
+ */
+class FileGradientSink : public GradientSink {
+private:
+    std::ofstream _file;
+    bool _header;
+
+public:
+    FileGradientSink(const std::string &path);
+
+    void publish(const int64_t utime, const std::vector<std::string> &names, const std::vector<float> &values);
+};
+
+/**
+ * @brief The MemoryGradientSink class
+ * Keep gradients in memory, e.g. for testing.
+ */
+class MemoryGradientSink : public GradientSink {
+private:
+    mutable std::mutex _mutex;
+    std::vector<int64_t> _utimes;
+    std::vector<std::vector<float> > _samples;
+
+public:
+    void publish(const int64_t utime, const std::vector<std::string> &names, const std::vector<float> &values);
+
+    /**
+     * @brief samples copy of all received gradient samples
+     */
+    std::vector<std::vector<float> > samples() const;
+
+    /**
+     * @brief utimes copy of timestamps of all received gradient samples
+     */
+    std::vector<int64_t> utimes() const;
+};
+
+/**
+ * @brief The GradientTelemetry class
+ * Decouples gradient publishing from the optimizer. The optimizer pushes raw
+ * gradient values into a lock-free single-producer single-consumer queue and a
+ * background thread serialises and publishes the newest sample at a configurable
+ * rate. Samples are dropped, and reported, if the queue is full because the
+ * consumer falls behind.
+ */
+class GradientTelemetry {
+private:
+    GradientSink *_sink;
+
+    // all joints of the pose and the subset that is published
+    const int _dims;
+    std::vector<int> _selected;
+    std::vector<std::string> _names;
+
+    // ring buffer of samples, _head is only written by producer, _tail only by consumer
+    const unsigned int _capacity;
+    std::vector<std::vector<float> > _slots;
+    std::vector<int64_t> _slot_utimes;
+    std::atomic<uint64_t> _head;
+    std::atomic<uint64_t> _tail;
+
+    std::atomic<double> _rate;
+    std::atomic<uint64_t> _dropped;
+    std::atomic<uint64_t> _published;
+    std::atomic<bool> _running;
+    std::thread _thread;
+
+    void run();
+
+public:
+    /**
+     * @brief GradientTelemetry start telemetry thread for gradients of a pose
+     * @param sink transport of gradient samples, must outlive the telemetry
+     * @param pose pose defining the joint names and order of gradient values
+     * @param rate maximum publishing rate in Hz, publish every sample if 0
+     * @param filter_fixed do not publish joints with identical lower and upper limit
+     * @param capacity number of samples in queue
+     */
+    GradientTelemetry(GradientSink *sink, const Pose &pose, const double rate, const bool filter_fixed = false, const unsigned int capacity = 64);
+
+    ~GradientTelemetry();
+
+    /**
+     * @brief push enqueue gradient sample, called by the optimizer without blocking
+     * @param values gradient values in joint order of pose
+     * @param n number of values
+     * @return false if sample was dropped
+     */
+    bool push(const float *values, const int n);
+
+    /**
+     * @brief setRate change maximum publishing rate
+     * @param rate maximum publishing rate in Hz, publish every sample if 0
+     */
+    void setRate(const double rate) { _rate = rate; }
+
+    /**
+     * @brief dropped number of samples dropped because the queue was full
+     */
+    uint64_t dropped() const { return _dropped; }
+
+    /**
+     * @brief published number of samples handed to the sink
+     */
+    uint64_t published() const { return _published; }
+};
+
+}
+
+#endif // GRADIENT_TELEMETRY_HPP
@@ -0,0 +1,52 @@
+#ifndef HOST_IMAGE_OPS_HPP
+#define HOST_IMAGE_OPS_HPP
+
+#include <cstddef>
+
+#ifdef CUDA_BUILD
+#include <vector_types.h>
+#else
+#include <dart/util/vector_type_template.h>
+#endif
+
+namespace dart {
+
+/**
+ * Host image operations for the debug visualisation. The kernels process 4 pixels
+ * at once with SSE2 where available and fall back to scalar loops otherwise. Input
+ * values are read with a stride in elements, so that e.g. the depth (z) of a host
+ * copy of a float4 vertex map can be colored in place with stride 4.
+ */
+namespace host {
+
+/**
+ * @brief depthToGray color depth in [min,max] meters from black to white
+ * @param img output image
+ * @param depth input depth, 0 for invalid pixels
+ * @param size number of pixels
+ * @param scaleToMeters scale of depth values to meters
+ * @param min depth in meters colored black, closer pixels are clamped
+ * @param max depth in meters colored white, farther pixels are clamped
+ * @param invalid color of invalid pixels
+ * @param stride distance of consecutive depth values in elements
+ */
+template<typename DepthType>
+void depthToGray(uchar3 *img, const DepthType *depth, const size_t size, const float scaleToMeters,
+                 const float min, const float max, const uchar3 invalid, const size_t stride = 1);
+
+/**
+ * @brief heatMap color values in [min,max] from blue over cyan, green and yellow to red
+ * Values outside of [min,max] and NaN are black.
+ * @param img output image
+ * @param values input values
+ * @param size number of pixels
+ * @param squared color squared values, e.g. of signed distance errors
+ */
+void heatMap(uchar3 *img, const float *values, const size_t size, const float min, const float max,
+             const bool squared = false);
+
+}
+
+}
+
+#endif // HOST_IMAGE_OPS_HPP
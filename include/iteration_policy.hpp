@@ -0,0 +1,116 @@
+#ifndef ITERATION_POLICY_HPP
+#define ITERATION_POLICY_HPP
+
+#include <chrono>
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The IterationPolicy class
+ * Decides after each Gauss-Newton iteration whether the pose optimization of the
+ * current frame continues. It stops if the pose converged, i.e. the norm of the
+ * parameter update or the relative change of the error falls below a threshold,
+ * if the next iteration would exceed the wall-clock budget of the frame, or after
+ * the maximum number of iterations. A threshold or budget of 0 disables the criterion.
+ * If all criteria are disabled, the iterations of a frame can be run in one call of
+ * the solver and accounted for at once with endIterations().
+ */
+class IterationPolicy {
+public:
+    enum StopReason {
+        MaxIterations = 0,
+        Converged,
+        ErrorStalled,
+        BudgetExhausted,
+        // no iteration was run in the frame, e.g. while paused
+        NotOptimized,
+        NumStopReasons
+    };
+
+    static const char * stopReasonName(const StopReason reason);
+
+private:
+    int _max_iterations;
+    float _min_update;
+    float _min_error_change;
+    double _budget;
+
+    // state of current frame
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point _frame_start;
+    Clock::time_point _iteration_start;
+    double _max_iteration_time;
+    std::vector<float> _params;
+    float _error;
+    float _update;
+    int _iterations;
+    StopReason _reason;
+
+public:
+    /**
+     * @brief IterationPolicy
+     * @param max_iterations maximum number of iterations per frame
+     * @param min_update minimum L2 norm of the change of all pose parameters (m, rad)
+     * @param min_error_change minimum change of the error relative to the previous iteration
+     * @param budget wall-clock budget of the optimization per frame in ms
+     */
+    IterationPolicy(const int max_iterations = 3, const float min_update = 0, const float min_error_change = 0, const double budget = 0);
+
+    void setMaxIterations(const int max_iterations) { _max_iterations = max_iterations; }
+    void setMinUpdate(const float min_update) { _min_update = min_update; }
+    void setMinErrorChange(const float min_error_change) { _min_error_change = min_error_change; }
+    void setBudget(const double budget) { _budget = budget; }
+
+    /**
+     * @brief stopsEarly any criterion may stop a frame before the maximum number of iterations
+     */
+    bool stopsEarly() const { return _min_update>0 || _min_error_change>0 || _budget>0; }
+
+    /**
+     * @brief beginFrame start the frame with the pose parameters before optimization
+     * @param params pose parameters of all models
+     * @param n number of parameters
+     * @return false if no iteration is allowed in this frame
+     */
+    bool beginFrame(const float *params, const int n);
+
+    /**
+     * @brief endIteration account for one iteration
+     * @param params pose parameters after the iteration, same layout as in beginFrame()
+     * @param error error after the iteration
+     * @return true if another iteration should be run
+     */
+    bool endIteration(const float *params, const float error);
+
+    /**
+     * @brief endIterations account for the maximum number of iterations run at once, ends the frame
+     * @param params pose parameters after the iterations, same layout as in beginFrame()
+     * @param error error after the last iteration
+     */
+    void endIterations(const float *params, const float error);
+
+    /**
+     * @brief iterations number of iterations run in the current frame
+     */
+    int iterations() const { return _iterations; }
+
+    /**
+     * @brief stopReason reason for stopping the current frame
+     */
+    StopReason stopReason() const { return _reason; }
+
+    /**
+     * @brief lastUpdate norm of the parameter update of the last iteration
+     */
+    float lastUpdate() const { return _update; }
+
+    /**
+     * @brief elapsed time since beginFrame() in ms
+     */
+    double elapsed() const;
+};
+
+}
+
+#endif // ITERATION_POLICY_HPP
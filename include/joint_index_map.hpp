@@ -0,0 +1,85 @@
+#ifndef JOINT_INDEX_MAP_HPP
+#define JOINT_INDEX_MAP_HPP
+
+#include <dart/tracker.h>
+
+#include <string>
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The JointIndexMap class
+ * Flat permutation from a source joint layout (e.g. reported robot state) to the
+ * reduced articulated joints of a destination pose. The joint names are resolved
+ * once and the mapping is only rebuilt if the joint names of one of the poses change.
+ * Afterwards, transferring joint values is a plain gather without any allocation.
+ */
+class JointIndexMap {
+private:
+    // source index for each destination joint, -1 if joint is not provided by source
+    std::vector<int> _index;
+    // joint limits applied to gathered values
+    std::vector<float> _min;
+    std::vector<float> _max;
+
+    // joint names of the layouts the map was built from
+    std::vector<std::string> _src_names;
+    std::vector<std::string> _dst_names;
+    // false if built from a name list, which is not compared to a source pose
+    bool _src_is_pose;
+
+    int _num_mapped;
+
+    void reset(const int dst_dims);
+
+    static bool sameLayout(const Pose &pose, const std::vector<std::string> &names);
+    static void storeLayout(const Pose &pose, std::vector<std::string> &names);
+
+public:
+    JointIndexMap();
+
+    /**
+     * @brief update rebuild mapping if the joint names of source or destination changed
+     * @param src pose providing joint values, its joint limits are used for clamping
+     * @param dst pose defining the joint order of gathered values
+     * @return true if the mapping was rebuilt
+     */
+    bool update(const Pose &src, const Pose &dst);
+
+    /**
+     * @brief build resolve mapping from list of source joint names, e.g. from an LCM message
+     * @param src_names names of source joints in order of their values
+     * @param dst pose defining the joint order of gathered values, its joint limits are used for clamping
+     */
+    void build(const std::vector<std::string> &src_names, const Pose &dst);
+
+    /**
+     * @brief gather copy source values into destination order and clamp them to joint limits
+     * Destination joints that are not provided by the source are left untouched.
+     * @param src source joint values
+     * @param dst destination joint values
+     */
+    void gather(const float *src, float *dst) const;
+
+    /**
+     * @brief size number of destination joints
+     */
+    int size() const { return _index.size(); }
+
+    /**
+     * @brief numMapped number of destination joints that are provided by the source
+     */
+    int numMapped() const { return _num_mapped; }
+
+    /**
+     * @brief sourceIndex index of source joint for given destination joint
+     * @param i destination joint index
+     * @return source joint index or -1 if not provided by source
+     */
+    int sourceIndex(const int i) const { return _index[i]; }
+};
+
+}
+
+#endif // JOINT_INDEX_MAP_HPP
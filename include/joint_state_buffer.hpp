@@ -0,0 +1,77 @@
+#ifndef JOINT_STATE_BUFFER_HPP
+#define JOINT_STATE_BUFFER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The JointStateBuffer class
+ * Lock-free triple buffer exchanging joint values between a single writer (e.g. the
+ * LCM subscriber thread) and a single reader (e.g. the tracking thread). The writer
+ * never waits for the reader and the reader always obtains a complete, consistent
+ * set of joint values together with its timestamp.
+ */
+class JointStateBuffer {
+private:
+    struct Slot {
+        std::vector<float> values;
+        int64_t utime;
+    };
+
+    Slot _slots[3];
+
+    // index of the slot shared between writer and reader, bit 2 marks new data
+    std::atomic<uint8_t> _middle;
+    // slots exclusively owned by writer and reader
+    uint8_t _back;
+    uint8_t _front;
+
+    static const uint8_t FRESH = 4;
+
+public:
+    /**
+     * @brief JointStateBuffer create buffer with initial joint values
+     * @param initial values of all joints, also defining the number of joints
+     */
+    JointStateBuffer(const std::vector<float> &initial);
+
+    /**
+     * @brief beginWrite get joint values of the writer slot to fill in place
+     * The slot contains the values of the previous write.
+     */
+    float * beginWrite();
+
+    /**
+     * @brief commit publish the values written since beginWrite
+     * @param utime timestamp of the joint values in microseconds
+     */
+    void commit(const int64_t utime);
+
+    /**
+     * @brief acquire switch to the most recently committed joint values
+     * @return true if new values were committed since the last acquire
+     */
+    bool acquire();
+
+    /**
+     * @brief values joint values of the last acquire
+     */
+    const float * values() const { return _slots[_front].values.data(); }
+
+    /**
+     * @brief utime timestamp of the joint values of the last acquire, 0 if nothing was committed yet
+     */
+    int64_t utime() const { return _slots[_front].utime; }
+
+    /**
+     * @brief size number of joints
+     */
+    int size() const { return _slots[0].values.size(); }
+};
+
+}
+
+#endif // JOINT_STATE_BUFFER_HPP
@@ -0,0 +1,78 @@
+#ifndef LCM_JOINT_STATE_HPP
+#define LCM_JOINT_STATE_HPP
+
+#include <dart/tracker.h>
+
+#include <joint_index_map.hpp>
+#include <joint_state_buffer.hpp>
+
+#include <lcm/lcm-cpp.hpp>
+#include <lcmtypes/bot_core/robot_state_t.hpp>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The LCM_JointStateSubscriber class
+ * Receives the reported robot state in its own LCM thread and exchanges the joint
+ * values with the tracking thread through a lock-free triple buffer. The tracking
+ * thread takes one consistent, timestamped snapshot per frame and the subscriber
+ * thread never blocks the tracking thread.
+ */
+class LCM_JointStateSubscriber {
+private:
+    lcm::LCM _lcm;
+
+    // pose defining the order of reported joints
+    const Pose &_layout;
+
+    // mapping of message joints to pose joints, rebuilt if joint names of messages change
+    JointIndexMap _joint_map;
+    std::vector<std::string> _msg_joint_names;
+
+    // messages with mismatching number of names and positions
+    unsigned long _num_dropped;
+
+    JointStateBuffer _buffer;
+
+    std::atomic<bool> _running;
+    std::thread _thread;
+
+    void run();
+
+    void onRobotState(const lcm::ReceiveBuffer *rbuf, const std::string &channel, const bot_core::robot_state_t *msg);
+
+public:
+    /**
+     * @brief LCM_JointStateSubscriber subscribe to robot state in a separate thread
+     * @param layout pose defining the order of joint values, its reduction must outlive the subscriber
+     * @param channel LCM channel of bot_core::robot_state_t messages
+     * @param provider LCM provider URL, e.g. for log files, default provider if empty
+     */
+    LCM_JointStateSubscriber(const Pose &layout, const std::string &channel, const std::string &provider = "");
+
+    ~LCM_JointStateSubscriber();
+
+    /**
+     * @brief write set joint values from a robot state message, e.g. for replaying logs
+     * Must not be called concurrently with the subscriber thread. Messages with a
+     * different number of joint names and positions are dropped.
+     * @param msg robot state
+     */
+    void write(const bot_core::robot_state_t &msg);
+
+    /**
+     * @brief snapshot copy the latest consistent joint values into the pose
+     * @param pose pose with the same reduction as the layout pose
+     * @return timestamp of joint values in microseconds, 0 if no state was received yet
+     */
+    int64_t snapshot(Pose &pose);
+};
+
+}
+
+#endif // LCM_JOINT_STATE_HPP
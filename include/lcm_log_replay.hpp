@@ -0,0 +1,106 @@
+#ifndef LCM_LOG_REPLAY_HPP
+#define LCM_LOG_REPLAY_HPP
+
+#include <lcm/lcm-cpp.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace dart {
+
+/**
+ * @brief The LCM_LogReplay class
+ * Replay of an lcmlog file, driven by the tracking loop instead of by the wall clock. Each call to next() replays the events up to and including the
+ * next event of the frame channel (e.g. "CAMERA"), in the order of their timestamps:
+ * events of subscribed channels (e.g. "EST_ROBOT_STATE") are decoded and handed to
+ * their callbacks in the calling thread, the frame event is republished on a host-local
+ * LCM bus on which the depth source listens, and next() waits until it was delivered.
+ * Thus every frame sees exactly the robot states that preceded its image in the log.
+ * A frame that is not delivered, e.g. because a datagram was lost, ends the replay
+ * with failed() set, instead of silently skipping it.
+ */
+class LCM_LogReplay {
+public:
+    typedef std::function<void(const lcm::LogEvent &)> EventHandler;
+
+private:
+    lcm::LogFile _log;
+    lcm::LCM _bus;
+    const double _speed;
+
+    std::string _frame_channel;
+    std::map<std::string, EventHandler> _handlers;
+
+    int _frames;
+    bool _failed;
+    int64_t _first_timestamp;
+    int64_t _timestamp;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    /**
+     * @brief LCM_LogReplay open log file for replay
+     * @param log_file path of lcmlog file
+     * @param bus LCM provider URL of the bus on which frame events are republished
+     * @param speed replay speed relative to recording, as fast as possible if 0
+     */
+    LCM_LogReplay(const std::string &log_file, const std::string &bus, const double speed = 0);
+
+    bool good() const { return _log.good() && _bus.good(); }
+
+    /**
+     * @brief localBus host-local LCM bus (ttl=0) on a port that is not in use, so that
+     * concurrent replays and live systems on the same host do not receive each other's events
+     * @return provider URL of the bus, empty if no free port was found
+     */
+    static std::string localBus();
+
+    /**
+     * @brief setFrameChannel channel of the events that start a new frame, e.g. depth images
+     */
+    void setFrameChannel(const std::string &channel) { _frame_channel = channel; }
+
+    /**
+     * @brief subscribe decode events of channel and pass them to callback during next()
+     */
+    template<typename Msg>
+    void subscribe(const std::string &channel, const std::function<void(const Msg &)> &callback) {
+        // message is reused for decoding, i.e. its buffers only grow
+        std::shared_ptr<Msg> msg(new Msg());
+        _handlers[channel] = [msg, callback](const lcm::LogEvent &event) {
+            if(msg->decode(event.data, 0, event.datalen)>=0)
+                callback(*msg);
+        };
+    }
+
+    /**
+     * @brief next replay events up to the next frame event
+     * @param delivered returns true once the receiver got the republished frame event
+     * @param timeout maximum time in ms to wait for delivery
+     * @return false at the end of the log or if the frame was not delivered, see failed()
+     */
+    bool next(const std::function<bool()> &delivered, const int timeout = 5000);
+
+    /**
+     * @brief frames number of frame events replayed
+     */
+    int frames() const { return _frames; }
+
+    /**
+     * @brief failed true if the replay stopped because a frame was not delivered
+     */
+    bool failed() const { return _failed; }
+
+    /**
+     * @brief timestamp log timestamp of the last frame event in microseconds
+     */
+    int64_t timestamp() const { return _timestamp; }
+};
+
+}
+
+#endif // LCM_LOG_REPLAY_HPP
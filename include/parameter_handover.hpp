@@ -0,0 +1,57 @@
+#ifndef PARAMETER_HANDOVER_HPP
+#define PARAMETER_HANDOVER_HPP
+
+#include <mutex>
+
+namespace dart {
+
+/**
+ * @brief The ParameterHandover class
+ * Hands parameters sampled by the UI thread (e.g. from Pangolin variables) over to the
+ * tracking thread, which then never accesses the UI itself. Values of the latest
+ * published parameters replace older ones, while one-shot requests (e.g. pushed buttons)
+ * are accumulated until the tracking thread took them, so no request is lost if the UI
+ * publishes faster than the tracking thread runs.
+ *
+ * T is copyable and provides:
+ * - void merge(const T &newer): take the values of newer and keep the own pending requests
+ * - void clearRequests(): mark all requests as handled
+ */
+template<typename T>
+class ParameterHandover {
+private:
+    T _pending;
+    bool _fresh;
+    std::mutex _mutex;
+
+public:
+    ParameterHandover() : _fresh(false) { }
+
+    /**
+     * @brief publish make parameters available to the tracking thread, UI thread
+     */
+    void publish(const T &params) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _pending.merge(params);
+        _fresh = true;
+    }
+
+    /**
+     * @brief take take the latest parameters with all requests since the last call, tracking thread
+     * @param params replaced by the latest parameters if new parameters were published
+     * @return true if params was replaced
+     */
+    bool take(T &params) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_fresh)
+            return false;
+        params = _pending;
+        _pending.clearRequests();
+        _fresh = false;
+        return true;
+    }
+};
+
+}
+
+#endif // PARAMETER_HANDOVER_HPP
@@ -0,0 +1,105 @@
+#ifndef POINT_BATCH_HPP
+#define POINT_BATCH_HPP
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+#ifdef CUDA_BUILD
+#include <vector_types.h>
+#else
+#include <dart/util/vector_type_template.h>
+#endif
+
+namespace dart {
+
+/**
+ * @brief The SdfColorTable class
+ * Colors of all SDFs of all models, looked up by the (model, sdf) label of a predicted
+ * point, i.e. model in the upper and SDF in the lower 16 bit.
+ */
+class SdfColorTable {
+private:
+    std::vector<uchar3> _colors;
+    // index of the first SDF color of each model, followed by the total number of colors
+    std::vector<int> _model_offset;
+    uchar3 _unknown;
+
+public:
+    SdfColorTable();
+
+    /**
+     * @brief addModel append colors of the SDFs of the next model
+     */
+    void addModel(const std::vector<uchar3> &sdf_colors);
+
+    int numModels() const { return int(_model_offset.size())-1; }
+
+    /**
+     * @brief color color of label, gray for unknown models and SDFs
+     */
+    uchar3 color(const int label) const {
+        const int model = label >> 16;
+        const int sdf = label & 0xffff;
+        if(model<0 || model>=numModels() || sdf>=_model_offset[model+1]-_model_offset[model])
+            return _unknown;
+        return _colors[_model_offset[model]+sdf];
+    }
+};
+
+/**
+ * @brief The PointBatch class
+ * Point cloud drawn with a single draw call from a VBO of interleaved positions and
+ * colors. The batch is built on the host in one pass over a vertex map, skipping
+ * points without depth, and uploaded once per build.
+ */
+class PointBatch {
+public:
+    struct Vertex {
+        float x, y, z;
+        unsigned char r, g, b, a;
+    };
+
+private:
+    const size_t _capacity;
+    std::vector<Vertex> _vertices;
+    GLuint _vbo;
+    bool _uploaded;
+
+    PointBatch(const PointBatch&);
+    PointBatch & operator=(const PointBatch&);
+
+public:
+    /**
+     * @brief PointBatch create VBO in the current GL context
+     * @param capacity maximum number of points
+     */
+    PointBatch(const size_t capacity);
+
+    ~PointBatch();
+
+    /**
+     * @brief buildLabelled build batch of points colored by the SDF of their label
+     * @param points vertex map with the (model, sdf) label of each point in w
+     */
+    void buildLabelled(const float4 *points, const size_t num_points, const SdfColorTable &colors);
+
+    /**
+     * @brief buildColored build batch of points with per point colors, e.g. by error
+     */
+    void buildColored(const float4 *points, const uchar3 *colors, const size_t num_points);
+
+    void clear() { _vertices.clear(); _uploaded = false; }
+
+    size_t size() const { return _vertices.size(); }
+
+    /**
+     * @brief draw draw batch with GL_POINTS, uploading it first if it was rebuilt
+     */
+    void draw();
+};
+
+}
+
+#endif // POINT_BATCH_HPP
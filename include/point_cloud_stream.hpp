@@ -0,0 +1,106 @@
+#ifndef POINT_CLOUD_STREAM_HPP
+#define POINT_CLOUD_STREAM_HPP
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+#ifdef CUDA_BUILD
+#include <vector_types.h>
+#else
+#include <dart/util/vector_type_template.h>
+#endif
+
+namespace dart {
+
+/**
+ * @brief The PointCloudStream class
+ * Streams a point cloud of up to a fixed number of points to the GL every frame
+ * and draws the valid points by a compacted index list.
+ *
+ * With ARB_buffer_storage, each stream (vertices, normals, colors, indices) is a
+ * persistently mapped ring of buffer segments: a frame is copied into the next
+ * segment, which is guarded by a fence until the GL has drawn from it, so the
+ * upload neither reallocates nor synchronises with the draw of the previous frame.
+ * Without it (or if disabled), buffers are orphaned and only the used range is
+ * uploaded with glBufferSubData. Streams that are not given are not uploaded.
+ */
+class PointCloudStream {
+public:
+    enum Stream {
+        Vertices = 0,
+        Normals,
+        Colors,
+        Indices,
+        NumStreams
+    };
+
+    static const int NumSegments = 3;
+
+private:
+    const size_t _capacity;
+    bool _persistent;
+
+    GLuint _buffers[NumStreams];
+    size_t _element_size[NumStreams];
+    // persistent mapping of the whole ring of each stream
+    unsigned char *_mapped[NumStreams];
+    GLsync _fences[NumSegments];
+    int _segment;
+
+    // streams and number of indices of the last upload
+    bool _uploaded[NumStreams];
+    size_t _offset[NumStreams];
+    size_t _num_indices;
+    size_t _uploaded_bytes;
+
+    PointCloudStream(const PointCloudStream&);
+    PointCloudStream & operator=(const PointCloudStream&);
+
+    void createBuffers();
+    void write(const Stream stream, const void *data, const size_t count);
+
+public:
+    /**
+     * @brief PointCloudStream create buffers in the current GL context
+     * @param capacity maximum number of points per frame
+     * @param persistent use persistently mapped buffers if supported, orphaning otherwise
+     */
+    PointCloudStream(const size_t capacity, const bool persistent = true);
+
+    ~PointCloudStream();
+
+    bool persistent() const { return _persistent; }
+
+    /**
+     * @brief upload stream points of the next frame
+     * @param vertices vertices of all points
+     * @param normals normals of all points, or NULL
+     * @param colors colors of all points, or NULL
+     * @param indices indices of the points to draw, e.g. from compactValidPoints
+     * @param num_points number of points of vertices, normals and colors
+     */
+    void upload(const float4 *vertices, const float4 *normals, const uchar3 *colors,
+                const std::vector<unsigned int> &indices, const size_t num_points);
+
+    /**
+     * @brief draw draw the points of the last upload with GL_POINTS
+     * Colors are used if uploaded, otherwise normals if uploaded.
+     */
+    void draw();
+
+    /**
+     * @brief uploadedBytes bytes copied to the GL by the last upload
+     */
+    size_t uploadedBytes() const { return _uploaded_bytes; }
+
+    /**
+     * @brief compactValidPoints indices of the points with depth, i.e. z != 0
+     */
+    static void compactValidPoints(const float4 *vertices, const size_t num_points, std::vector<unsigned int> &indices);
+};
+
+}
+
+#endif // POINT_CLOUD_STREAM_HPP
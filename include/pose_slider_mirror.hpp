@@ -0,0 +1,112 @@
+#ifndef POSE_SLIDER_MIRROR_HPP
+#define POSE_SLIDER_MIRROR_HPP
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include <pangolin/var/var.h>
+
+#include <dart/tracker.h>
+
+namespace dart {
+
+/**
+ * @brief The PoseSliderMirror class
+ * Mirror of the pose sliders between the tracking thread and the UI thread. Per model,
+ * the sliders are the translation, rotation (se3) and articulated parameters.
+ *
+ * The tracking thread publishes poses after optimization. Only parameters that changed
+ * are recorded in a compact list of pending changes, and the se3 of the root is only
+ * recomputed if the transform changed. The UI thread flushes pending changes to the
+ * Pangolin variables at a limited rate and only while the pose panel is shown.
+ * In the other direction, sliders moved by the user are collected by the UI thread
+ * and the tracking thread applies them to the poses of the affected models only.
+ */
+class PoseSliderMirror {
+private:
+    struct Change {
+        int index;
+        float value;
+    };
+
+    struct Model {
+        int offset;
+        int dims;
+        SE3 transform;
+        bool published;
+        bool slider_changed;
+    };
+
+    std::mutex _mutex;
+    std::vector<Model> _models;
+    std::vector<pangolin::Var<float> *> _vars;
+
+    // pose to sliders: last published value and pending change of each slider, -1 if none
+    std::vector<float> _published;
+    std::vector<int> _pending_slot;
+    std::vector<Change> _pending;
+    std::vector<Change> _flushing;
+    std::chrono::steady_clock::time_point _last_flush;
+
+    // sliders to pose: value of each slider as moved by the user
+    std::vector<float> _slider_values;
+    bool _slider_changed;
+
+    void stage(const int index, const float value);
+
+public:
+    PoseSliderMirror();
+
+    /**
+     * @brief addModel add sliders of the next model, in the layout of the pose sliders
+     * @param vars translation, rotation and articulated parameter sliders
+     * @param dims number of sliders, 6 plus the reduced articulated dimensions
+     */
+    void addModel(pangolin::Var<float> * const *vars, const int dims);
+
+    int numModels() const { return _models.size(); }
+
+    /**
+     * @brief publish record changed parameters of the pose of model, tracking thread
+     */
+    void publish(const int model, const Pose &pose);
+
+    /**
+     * @brief flush push pending changes to the sliders, UI thread
+     * @param visible sliders are shown, otherwise changes stay pending
+     * @param min_interval minimum time between flushes in seconds
+     * @return number of sliders updated
+     */
+    int flush(const bool visible, const double min_interval);
+
+    /**
+     * @brief collectSliderChanges collect sliders moved by the user, UI thread
+     * @param record record the changes to be applied, otherwise they are discarded
+     */
+    void collectSliderChanges(const bool record);
+
+    /**
+     * @brief applySliderChanges apply sliders of models with changed sliders, tracking thread
+     * @param apply called with model index and its slider values
+     * @return true if any model was changed
+     */
+    template<typename Apply>
+    bool applySliderChanges(Apply apply) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(!_slider_changed)
+            return false;
+        for(size_t m=0; m<_models.size(); m++) {
+            if(_models[m].slider_changed) {
+                apply(int(m), &_slider_values[_models[m].offset]);
+                _models[m].slider_changed = false;
+            }
+        }
+        _slider_changed = false;
+        return true;
+    }
+};
+
+}
+
+#endif // POSE_SLIDER_MIRROR_HPP
@@ -3,28 +3,52 @@
 
 #include <dart/tracker.h>
 
-// publishing the prior gradient
-#define LCM_DEBUG_GRADIENT
-
-// filter fixed joints for shorter messages
-// this will introduce a delay and should be compensated by skip publishing for
-// a certain amount of iterations
-#define FILTER_FIXED_JOINTS 0
+#include <joint_index_map.hpp>
+#include <sparse_block.hpp>
+#include <gradient_telemetry.hpp>
 
 // activate to print joint names and ids once at initialising the joint prior
 //#define DBG_PRINT_JOINTS
 
 namespace dart {
 
+/**
+ * @brief The GNWorkspace struct
+ * Preallocated Gauss-Newton buffers of a prior. They are only resized if the
+ * joint dimension changes, so the steady-state prior computation does not allocate.
+ * The priors have no fixed-size specialisation per joint count: in bench_priors it
+ * ran within noise of these buffers, as the time goes to the joint gather and scatter.
+ */
+struct GNWorkspace {
+    // difference of reported to estimated joint values
+    Eigen::VectorXf diff;
+    // gradient J^T*r
+    Eigen::VectorXf JTe;
+    // J^T*J, constant for quadratic priors
+    Eigen::SparseMatrix<float> JTJ;
+
+    /**
+     * @brief resize resize buffers if joint dimension changed
+     * @param dims number of joints
+     * @return true if buffers were resized
+     */
+    bool resize(const int dims);
+};
+
 /**
  * @brief The NoCameraMovementPrior class
  * Prior to prevent movement of camera, e.g. set transformation of model to camera to 0.
- * This prior needs to be added last to enforce no transformation.
+ * The 6 transformation parameters of the model are frozen by decoupling their rows and
+ * columns from the system, which shrinks the effective system instead of solving it.
+ * Priors on the articulated parameters can be added in any order, only priors on the
+ * transformation of the same model that are added after this prior are not frozen.
  */
 class NoCameraMovementPrior : public Prior {
 private:
     int _srcModelID;
 
+    SparseBlockAccumulator _accumulator;
+
 public:
     NoCameraMovementPrior(const int srcModelID);
 
@@ -37,34 +61,96 @@ public:
                              const OptimizationOptions & opts);
 };
 
+/**
+ * @brief The ReportedJointsPrior class
+ * Pulls the estimated joints towards the reported joints. The prior is formulated
+ * as residual vector r = W*(est - reported) with Jacobian W, so the Gauss-Newton
+ * contribution is J^T*J = W^T*W for all joints and J^T*r = -W^T*W*diff.
+ * Subclasses define the weighting W^T*W.
+ */
 class ReportedJointsPrior : public Prior {
 private:
     // references to both pose sources for continuous updates
     const Pose &_reported;
     const Pose &_estimated;
     const int _modelID;
-#if FILTER_FIXED_JOINTS
-    unsigned int _skipped;
-#endif
+
+    // mapping of reported joints to estimated joints, rebuilt if reduction of any pose changes
+    JointIndexMap _joint_map;
+
+    // scatter of the prior block into the full system
+    SparseBlockAccumulator _accumulator;
+
+    // asynchronous publishing of the prior gradient, disabled if NULL
+    GradientTelemetry *_telemetry;
 
     /**
-     * @brief computeGNParam compute parameter for Gauss-Newton
-     * @param diff vector of differences in joint angles
-     * @return tuple with Jacobian J and the gradient J^T*e
+     * @brief computeJTJ compute the weighting W^T*W of the residuals
+     * This is called once and whenever the joint dimension changes.
+     * @param JTJ output sparse square matrix
+     * @param dims number of joints
      */
-    virtual std::tuple<Eigen::MatrixXf, Eigen::VectorXf> computeGNParam(const Eigen::VectorXf &diff) = 0;
+    virtual void computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const = 0;
+
+    /**
+     * @brief computeGNParam compute parameter for Gauss-Newton in place
+     * The default computes the gradient J^T*r = -JTJ*diff of the quadratic prior.
+     * @param ws workspace with vector of differences in joint angles in ws.diff,
+     * the gradient is written to ws.JTe and JTJ may be updated in ws.JTJ
+     */
+    virtual void computeGNParam(GNWorkspace &ws);
 
-#if FILTER_FIXED_JOINTS
     void setup();
-#endif
 
 #ifdef DBG_PRINT_JOINTS
     void printJointList();
 #endif
 
 protected:
+    // buffers of the Gauss-Newton parameters
+    GNWorkspace _ws;
+
+    /**
+     * @brief prepare resize workspace and compute JTJ if the joint dimension changed
+     */
+    void prepare();
+
+    /**
+     * @brief computeDiff compute difference of reported to estimated joint values
+     * @param diff output of size equal to the reduced articulated dimensions of the estimated pose
+     */
+    void computeDiff(float *diff);
+
+    /**
+     * @brief publishGradient push gradient to telemetry for debugging, if enabled
+     * @param JTe gradient of size equal to the reduced articulated dimensions of the estimated pose
+     */
+    void publishGradient(const float *JTe);
+
+    /**
+     * @brief addContribution add prior JTJ and JTe to articulated parameters of the model in the full system
+     */
+    void addContribution(Eigen::SparseMatrix<float> & fullJTJ,
+                         Eigen::VectorXf & fullJTe,
+                         const int * modelOffsets,
+                         const Eigen::SparseMatrix<float> &JTJ,
+                         const Eigen::Ref<const Eigen::VectorXf> &JTe);
+
+    /**
+     * @brief dims number of reduced articulated joints of the estimated pose
+     */
+    int dims() const { return _estimated.getReducedArticulatedDimensions(); }
+
+    /**
+     * @brief weightMatrix weight matrix Q, or weight*I if Q does not match the joint dimension
+     * @param W output sparse square matrix
+     * @param dims number of joints
+     */
+    void weightMatrix(Eigen::SparseMatrix<float> &W, const int dims) const;
+
     const double _weight;
-    const Eigen::MatrixXf _Q;
+    // square weight matrix, sparse to support diagonal and block-diagonal weights
+    const Eigen::SparseMatrix<float> _Q;
 
 public:
     /**
@@ -85,6 +171,21 @@ public:
      */
     explicit ReportedJointsPrior(const int modelID, const Pose &reported, const Pose &current, const Eigen::MatrixXf Q);
 
+    /**
+     * @brief ReportedJointsPrior constructor for weights in sparse matrix form, e.g. diagonal or block-diagonal per finger
+     * @param modelID ID of model in DART tracker
+     * @param reported reported pose
+     * @param current estimated pose
+     * @param Q sparse square weight matrix with dimensions like joint vector
+     */
+    explicit ReportedJointsPrior(const int modelID, const Pose &reported, const Pose &current, const Eigen::SparseMatrix<float> &Q);
+
+    /**
+     * @brief setTelemetry publish the prior gradient asynchronously for debugging
+     * @param telemetry telemetry created for the estimated pose, NULL to disable publishing
+     */
+    void setTelemetry(GradientTelemetry *telemetry) { _telemetry = telemetry; }
+
     void computeContribution(Eigen::SparseMatrix<float> & fullJTJ,
                                  Eigen::VectorXf & fullJTe,
                                  const int * modelOffsets,
@@ -94,28 +195,145 @@ public:
                                  const OptimizationOptions & opts);
 };
 
+/**
+ * @brief The WeightedL2NormOfError class
+ * Residual r = weight*diff, e.g. J^T*J = weight^2*I.
+ */
 class WeightedL2NormOfError : public ReportedJointsPrior {
     using ReportedJointsPrior::ReportedJointsPrior;
 private:
-    std::tuple<Eigen::MatrixXf, Eigen::VectorXf> computeGNParam(const Eigen::VectorXf &diff);
+    void computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const;
 };
 
+/**
+ * @brief The L2NormOfWeightedError class
+ * Residual r = W*diff with weight matrix W, e.g. J^T*J = W^T*W.
+ * For scalar weights, this is identical to WeightedL2NormOfError.
+ */
 class L2NormOfWeightedError : public ReportedJointsPrior {
     using ReportedJointsPrior::ReportedJointsPrior;
 private:
-    std::tuple<Eigen::MatrixXf, Eigen::VectorXf> computeGNParam(const Eigen::VectorXf &diff);
+    void computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const;
 };
 
+/**
+ * @brief The QWeightedError class
+ * Error diff^T*Q*diff, e.g. J^T*J = (Q + Q^T)/2, which is Q for symmetric Q.
+ */
 class QWeightedError : public ReportedJointsPrior {
     using ReportedJointsPrior::ReportedJointsPrior;
 private:
-    std::tuple<Eigen::MatrixXf, Eigen::VectorXf> computeGNParam(const Eigen::VectorXf &diff);
+    void computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const;
 };
 
+/**
+ * @brief The SimpleWeightedError class
+ * Unweighted residual r = diff, e.g. J^T*J = I.
+ */
 class SimpleWeightedError : public ReportedJointsPrior {
     using ReportedJointsPrior::ReportedJointsPrior;
 private:
-    std::tuple<Eigen::MatrixXf, Eigen::VectorXf> computeGNParam(const Eigen::VectorXf &diff);
+    void computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const;
+};
+
+/**
+ * @brief The RobustWeightedError class
+ * Per-joint robust kernel on the weighted residuals r_i = q_i*diff_i, with the
+ * diagonal q of the weight matrix. The kernel is minimised by iteratively
+ * reweighted least squares: each evaluation computes the weights
+ * omega_i = psi(r_i)/r_i of the current residuals, e.g. J^T*J = diag(omega*q^2).
+ * Joints with large deviations, e.g. from a bad encoder reading, get a small
+ * weight and do not dominate the estimate.
+ * Subclasses define the robust kernel.
+ */
+class RobustWeightedError : public ReportedJointsPrior {
+private:
+    // kernel scale, residuals below are treated (approximately) quadratic
+    float _scale;
+
+    // squared per-joint weights q^2, residuals and IRLS weights
+    Eigen::ArrayXf _q2;
+    Eigen::ArrayXf _r;
+    Eigen::ArrayXf _omega;
+
+    void diagonalWeights(Eigen::ArrayXf &q2, const int dims) const;
+
+    void computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const;
+
+    void computeGNParam(GNWorkspace &ws);
+
+    /**
+     * @brief computeWeights compute IRLS weights of all residuals in a single vectorized pass
+     * @param r weighted residuals
+     * @param scale kernel scale
+     * @param omega output weights in [0,1]
+     */
+    virtual void computeWeights(const Eigen::ArrayXf &r, const float scale, Eigen::ArrayXf &omega) const = 0;
+
+public:
+    /**
+     * @brief RobustWeightedError constructor for scalar weights
+     * @param modelID ID of model in DART tracker
+     * @param reported reported pose
+     * @param current estimated pose
+     * @param weight scalar weight
+     * @param scale kernel scale in units of the weighted residual
+     */
+    explicit RobustWeightedError(const int modelID, const Pose &reported, const Pose &current, const double weight, const float scale);
+
+    /**
+     * @brief RobustWeightedError constructor for per-joint weights
+     * @param modelID ID of model in DART tracker
+     * @param reported reported pose
+     * @param current estimated pose
+     * @param Q square weight matrix with dimensions like joint vector, only the diagonal is used
+     * @param scale kernel scale in units of the weighted residual
+     */
+    explicit RobustWeightedError(const int modelID, const Pose &reported, const Pose &current, const Eigen::MatrixXf Q, const float scale);
+
+    /**
+     * @brief RobustWeightedError constructor for per-joint weights in sparse matrix form
+     * @param modelID ID of model in DART tracker
+     * @param reported reported pose
+     * @param current estimated pose
+     * @param Q sparse square weight matrix with dimensions like joint vector, only the diagonal is used
+     * @param scale kernel scale in units of the weighted residual
+     */
+    explicit RobustWeightedError(const int modelID, const Pose &reported, const Pose &current, const Eigen::SparseMatrix<float> &Q, const float scale);
+
+    void setScale(const float scale) { _scale = scale; }
+
+    float getScale() const { return _scale; }
+};
+
+/**
+ * @brief The HuberWeightedError class
+ * Huber kernel, quadratic for |r| <= scale and linear above, e.g. omega = min(1, scale/|r|).
+ */
+class HuberWeightedError : public RobustWeightedError {
+    using RobustWeightedError::RobustWeightedError;
+private:
+    void computeWeights(const Eigen::ArrayXf &r, const float scale, Eigen::ArrayXf &omega) const;
+};
+
+/**
+ * @brief The CauchyWeightedError class
+ * Cauchy kernel, logarithmic for large residuals, e.g. omega = 1/(1 + (r/scale)^2).
+ */
+class CauchyWeightedError : public RobustWeightedError {
+    using RobustWeightedError::RobustWeightedError;
+private:
+    void computeWeights(const Eigen::ArrayXf &r, const float scale, Eigen::ArrayXf &omega) const;
+};
+
+/**
+ * @brief The TukeyWeightedError class
+ * Tukey biweight kernel, joints with |r| > scale are ignored, e.g. omega = (1 - (r/scale)^2)^2.
+ */
+class TukeyWeightedError : public RobustWeightedError {
+    using RobustWeightedError::RobustWeightedError;
+private:
+    void computeWeights(const Eigen::ArrayXf &r, const float scale, Eigen::ArrayXf &omega) const;
 };
 
 }
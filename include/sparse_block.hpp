@@ -0,0 +1,84 @@
+#ifndef SPARSE_BLOCK_HPP
+#define SPARSE_BLOCK_HPP
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The SparseBlockAccumulator class
+ * Adds dense blocks to a column-major sparse matrix in a single merge pass per
+ * column instead of a binary search (and potential insertion) per coefficient.
+ * Coefficients that are not part of the sparsity pattern yet are collected and
+ * inserted at the end. The collection buffer is kept between calls, so with a
+ * stable sparsity pattern no allocation happens.
+ */
+class SparseBlockAccumulator {
+private:
+    struct Entry {
+        int row;
+        int col;
+        float value;
+    };
+
+    // coefficients that are not yet stored in the sparse matrix
+    std::vector<Entry> _missing;
+
+    void insertMissing(Eigen::SparseMatrix<float> &M);
+
+public:
+    /**
+     * @brief addBlock add dense block to sparse matrix, M(row:row+B.rows(), col:col+B.cols()) += B
+     * Zero coefficients of the block are skipped.
+     * @param M sparse column-major matrix
+     * @param row first row of block in M
+     * @param col first column of block in M
+     * @param B dense block
+     */
+    void addBlock(Eigen::SparseMatrix<float> &M, const int row, const int col, const Eigen::Ref<const Eigen::MatrixXf> &B);
+
+    /**
+     * @brief addBlock add sparse block to sparse matrix, M(row:row+B.rows(), col:col+B.cols()) += B
+     * Only the stored coefficients of the block are visited.
+     * @param M sparse column-major matrix
+     * @param row first row of block in M
+     * @param col first column of block in M
+     * @param B sparse column-major block
+     */
+    void addBlock(Eigen::SparseMatrix<float> &M, const int row, const int col, const Eigen::SparseMatrix<float> &B);
+
+    /**
+     * @brief addDiagonal add vector to diagonal of sparse matrix, M(offset+i, offset+i) += d(i)
+     * @param M sparse column-major matrix
+     * @param offset first row and column of diagonal in M
+     * @param d diagonal values
+     */
+    void addDiagonal(Eigen::SparseMatrix<float> &M, const int offset, const Eigen::Ref<const Eigen::VectorXf> &d);
+
+    /**
+     * @brief addSegment add vector to segment of vector, v(offset:offset+s.size()) += s
+     * @param v full vector
+     * @param offset first index of segment in v
+     * @param s segment values
+     */
+    static void addSegment(Eigen::VectorXf &v, const int offset, const Eigen::Ref<const Eigen::VectorXf> &s);
+
+    /**
+     * @brief freezeParameters remove parameters from the solution of M*x = v
+     * The rows and columns of the parameters are cleared, their diagonal is set to 1 and
+     * their entries in v are set to 0. The remaining system is unchanged and the solution
+     * for the frozen parameters is 0.
+     * @param M sparse column-major system matrix
+     * @param v right-hand side of system
+     * @param offset index of first frozen parameter
+     * @param count number of frozen parameters
+     */
+    void freezeParameters(Eigen::SparseMatrix<float> &M, Eigen::VectorXf &v, const int offset, const int count);
+};
+
+}
+
+#endif // SPARSE_BLOCK_HPP
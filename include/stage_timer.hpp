@@ -0,0 +1,138 @@
+#ifndef STAGE_TIMER_HPP
+#define STAGE_TIMER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The LatencyHistogram class
+ * Log-linear histogram of durations in microseconds with 8 buckets per power of two,
+ * i.e. percentiles have a relative error below 6.25%. Recording is lock-free and
+ * only increments a few relaxed atomics, so it can be read while it is written.
+ */
+class LatencyHistogram {
+public:
+    static const int NumBuckets = 16 + 8*(64-4);
+
+private:
+    std::atomic<uint64_t> _buckets[NumBuckets];
+    std::atomic<uint64_t> _count;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+
+    static int bucket(const uint64_t us);
+    static uint64_t bucketMidpoint(const int b);
+
+public:
+    LatencyHistogram();
+
+    void record(const uint64_t us);
+
+    void reset();
+
+    uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+    double mean() const;
+    uint64_t max() const { return _max.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief percentile midpoint of the bucket containing the given percentile
+     * @param p percentile in [0,100]
+     * @return duration in microseconds, 0 if histogram is empty
+     */
+    uint64_t percentile(const double p) const;
+};
+
+/**
+ * @brief The StageTimers class
+ * Named stages of the tracking loop with a latency histogram each.
+ * Stages are added during setup, afterwards recording does not allocate.
+ */
+class StageTimers {
+private:
+    std::vector<std::string> _names;
+    std::vector<LatencyHistogram*> _histograms;
+
+public:
+    StageTimers() { }
+    ~StageTimers();
+
+    /**
+     * @brief addStage register a stage, must not be called while stages are recorded
+     * @return id of stage
+     */
+    int addStage(const std::string &name);
+
+    void record(const int stage, const uint64_t us) { _histograms[stage]->record(us); }
+
+    /**
+     * @brief dump write one line per stage with count, mean, p50, p95, p99 and max in ms
+     */
+    void dump(std::ostream &os) const;
+
+    void reset();
+
+private:
+    StageTimers(const StageTimers&);
+    StageTimers & operator=(const StageTimers&);
+};
+
+/**
+ * @brief The ScopedStageTimer class
+ * Records the time from construction to destruction in a stage.
+ */
+class ScopedStageTimer {
+private:
+    StageTimers &_timers;
+    const int _stage;
+    const std::chrono::steady_clock::time_point _start;
+
+public:
+    ScopedStageTimer(StageTimers &timers, const int stage)
+        : _timers(timers), _stage(stage), _start(std::chrono::steady_clock::now()) { }
+
+    ~ScopedStageTimer() {
+        _timers.record(_stage, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()-_start).count());
+    }
+};
+
+/**
+ * @brief The StatsServer class
+ * Background thread exposing stage statistics without GUI. Statistics are
+ * dumped to stdout at a fixed interval and/or served on a local Unix socket:
+ * each connection receives the current statistics, e.g. by
+ * "socat - UNIX-CONNECT:<path>". A connection sending "reset" also clears them.
+ */
+class StatsServer {
+private:
+    StageTimers &_timers;
+    const std::string _socket_path;
+    const double _interval;
+    int _socket;
+    std::atomic<bool> _running;
+    std::thread _thread;
+
+    void run();
+    void serve(const int client);
+
+public:
+    /**
+     * @brief StatsServer start statistics thread
+     * @param timers stage timers, must outlive the server
+     * @param socket_path path of Unix socket, no socket if empty
+     * @param interval interval of stdout dumps in seconds, no dumps if 0
+     */
+    StatsServer(StageTimers &timers, const std::string &socket_path, const double interval);
+
+    ~StatsServer();
+};
+
+}
+
+#endif // STAGE_TIMER_HPP
@@ -0,0 +1,94 @@
+#ifndef TRACKER_CONFIG_HPP
+#define TRACKER_CONFIG_HPP
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace dart {
+
+/**
+ * @brief The TrackerParameters struct
+ * Parameters of track_manipulation that trade tracking accuracy for latency.
+ * The keys in config files are the names of the corresponding sliders, e.g. "opt.itersPerFrame".
+ */
+struct TrackerParameters {
+    TrackerParameters();
+
+    int itersPerFrame;
+    // number of voxels along each side of the observation SDF, its extent is fixed
+    int obsSdfSize;
+    float modelSdfResolution;
+    float modelSdfPadding;
+    float distanceThreshold;
+    float infoAccumulationRate;
+    // convergence thresholds and wall-clock budget per frame in ms of the iteration policy
+    float minUpdateNorm;
+    float minErrorChange;
+    float frameBudget;
+
+    /**
+     * @brief set parameter by slider name
+     * @return false if key is not a tuned parameter or value cannot be parsed
+     */
+    bool set(const std::string &key, const std::string &value);
+
+    /**
+     * @brief write parameters as "key = value" lines
+     */
+    void write(std::ostream &os) const;
+};
+
+/**
+ * @brief The TrackerConfig struct
+ * Parameter set with its measured per-frame latency and tracking error on a recorded sequence.
+ * Metrics are negative if they have not been measured.
+ */
+struct TrackerConfig {
+    TrackerConfig() : frames(0), latencyMean(-1), latencyP95(-1), jointError(-1), iterationsMean(-1) { }
+
+    TrackerParameters params;
+
+    int frames;
+    // per-frame tracking latency in ms
+    float latencyMean;
+    float latencyP95;
+    // RMS deviation of tracked from reported joint angles in rad
+    float jointError;
+    // Gauss-Newton iterations per frame
+    float iterationsMean;
+
+    bool measured() const { return frames>0 && latencyP95>=0 && jointError>=0; }
+};
+
+/**
+ * @brief loadTrackerConfigs read configurations from file
+ * Each configuration starts with a line "[config]" and consists of "key = value" lines.
+ * A file without section lines contains a single configuration. Lines starting with '#' are comments.
+ * @return false if file cannot be read or contains invalid lines
+ */
+bool loadTrackerConfigs(const std::string &file, std::vector<TrackerConfig> &configs);
+
+/**
+ * @brief saveTrackerConfigs write configurations to file, readable by loadTrackerConfigs
+ * @param comment optional header, written as comment lines
+ */
+bool saveTrackerConfigs(const std::string &file, const std::vector<TrackerConfig> &configs, const std::string &comment = "");
+
+/**
+ * @brief paretoFrontier measured configurations that are not dominated in p95 latency and joint error
+ * @return frontier sorted by increasing latency, i.e. decreasing error
+ */
+std::vector<TrackerConfig> paretoFrontier(const std::vector<TrackerConfig> &configs);
+
+/**
+ * @brief selectTrackerConfig most accurate configuration within a latency budget
+ * @param budget p95 latency budget in ms, non-positive for the most accurate configuration
+ * @return index of configuration, the fastest one if none fits the budget,
+ *         the first one if none is measured, -1 if configs is empty
+ */
+int selectTrackerConfig(const std::vector<TrackerConfig> &configs, const float budget);
+
+}
+
+#endif // TRACKER_CONFIG_HPP
@@ -0,0 +1,109 @@
+#ifndef TRACKING_SNAPSHOT_HPP
+#define TRACKING_SNAPSHOT_HPP
+
+#include <vector>
+
+#include <iteration_policy.hpp>
+
+#ifdef CUDA_BUILD
+#include <vector_types.h>
+#else
+#include <dart/util/vector_type_template.h>
+#endif
+
+#include <dart/geometry/SE3.h>
+
+namespace dart {
+
+/**
+ * @brief The TrackingSnapshot struct
+ * Host copy of the tracking results of one frame for rendering. The tracking thread
+ * only captures the buffers that are enabled for display, all other buffers are empty.
+ */
+struct TrackingSnapshot {
+    // voxel grid of a signed distance function in model coordinates
+    struct Sdf {
+        uint3 dim;
+        float3 offset;
+        float resolution;
+        std::vector<float> data;
+    };
+
+    TrackingSnapshot() : frame(0), fps(0), mode(0), optimized(false), iterations(0), stopReason(IterationPolicy::NotOptimized), errObsToMod(0), errModToObs(0), flipDepthImage(false) {
+        plane.x = plane.y = plane.z = plane.w = 0;
+    }
+
+    int frame;
+    // tracked frames per second
+    float fps;
+
+    // tracking mode of the application, e.g. object on table or grasped
+    int mode;
+    // contact state of the fingers, empty without contact information
+    std::vector<int> contacts;
+    // normal and intercept of the supporting plane, e.g. the table
+    float4 plane;
+
+    // pose of each tracked model, transform to the camera and reduced articulation of all
+    // models one after another
+    std::vector<SE3> modelTransforms;
+    std::vector<float> modelArticulations;
+    // reported pose of the robot, transform to the camera and reduced articulation
+    SE3 reportedTransform;
+    std::vector<float> reportedArticulation;
+
+    // poses have been optimized in this frame
+    bool optimized;
+    // Gauss-Newton iterations run in this frame and why the optimization stopped
+    int iterations;
+    IterationPolicy::StopReason stopReason;
+
+    // error per observed and predicted point
+    float errObsToMod;
+    float errModToObs;
+
+    // observed point cloud with normals or colors, depth image size
+    std::vector<float4> obsVertMap;
+    std::vector<float4> obsNormMap;
+    std::vector<uchar3> obsColors;
+    // indices of the observed points with depth
+    std::vector<unsigned int> obsIndices;
+
+    // predicted point cloud with colors, prediction image size
+    std::vector<float4> predVertMap;
+    std::vector<uchar3> predColors;
+
+    // observed SDF of each model
+    std::vector<Sdf> obsSdfs;
+    // contact points of the fingers in contact, in the camera frame
+    std::vector<float4> contactPoints;
+
+    // debug images of depth and prediction image size
+    std::vector<uchar3> depthImage;
+    std::vector<uchar3> predImage;
+    // depth image has origin in the bottom left, e.g. JTJ image
+    bool flipDepthImage;
+
+    /**
+     * @brief clearBuffers clear buffers of the previous frame, keeping their memory
+     */
+    void clearBuffers() {
+        obsVertMap.clear();
+        obsNormMap.clear();
+        obsColors.clear();
+        obsIndices.clear();
+        predVertMap.clear();
+        predColors.clear();
+        for(size_t m=0; m<obsSdfs.size(); m++) {
+            obsSdfs[m].data.clear();
+        }
+        contactPoints.clear();
+        depthImage.clear();
+        predImage.clear();
+        flipDepthImage = false;
+    }
+};
+
+}
+
+#endif // TRACKING_SNAPSHOT_HPP
@@ -0,0 +1,132 @@
+#include <collision_cloud_batch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <xmmintrin.h>
+#endif
+
+dart::CollisionCloudBatch::CollisionCloudBatch() : _vbo_capacity(0), _uploaded(false) {
+    glGenBuffers(1, &_vbo);
+}
+
+dart::CollisionCloudBatch::~CollisionCloudBatch() {
+    glDeleteBuffers(1, &_vbo);
+}
+
+void dart::CollisionCloudBatch::setModel(const int model, const float4 *cloud, const int size, const std::vector<int> &sdf_frames) {
+    if(model >= (int)_models.size())
+        _models.resize(model+1);
+    ModelCloud &mc = _models[model];
+    mc.groups.clear();
+    mc.x.clear();
+    mc.y.clear();
+    mc.z.clear();
+
+    // points of each frame, in the order of the cloud
+    std::vector<std::vector<int> > frame_points;
+    for(int i=0; i<size; i++) {
+        const int sdf = int(std::lround(cloud[i].w));
+        if(sdf < 0 || sdf >= (int)sdf_frames.size())
+            continue;
+        const int frame = sdf_frames[sdf];
+        if(frame >= (int)frame_points.size())
+            frame_points.resize(frame+1);
+        frame_points[frame].push_back(i);
+    }
+
+    for(size_t f=0; f<frame_points.size(); f++) {
+        const std::vector<int> &points = frame_points[f];
+        if(points.empty())
+            continue;
+        Group group;
+        group.frame = f;
+        group.begin = mc.x.size();
+        group.size = (points.size()+3)/4*4;
+        for(size_t i=0; i<group.size; i++) {
+            const float4 &p = cloud[points[std::min(i, points.size()-1)]];
+            mc.x.push_back(p.x);
+            mc.y.push_back(p.y);
+            mc.z.push_back(p.z);
+        }
+        mc.groups.push_back(group);
+    }
+    mc.valid = true;
+
+    // vertices of the models are stored one after another
+    size_t offset = 0;
+    for(size_t m=0; m<_models.size(); m++) {
+        _models[m].vertex_offset = offset;
+        offset += _models[m].x.size();
+    }
+    _vertices.resize(offset);
+    _uploaded = false;
+}
+
+void dart::CollisionCloudBatch::transform(const int model, const std::vector<SE3> &frame_to_camera) {
+    if(!hasModel(model))
+        return;
+    const ModelCloud &mc = _models[model];
+
+    for(size_t g=0; g<mc.groups.size(); g++) {
+        const Group &group = mc.groups[g];
+        if(group.frame >= (int)frame_to_camera.size())
+            continue;
+        const SE3 &T = frame_to_camera[group.frame];
+        const float *x = &mc.x[group.begin];
+        const float *y = &mc.y[group.begin];
+        const float *z = &mc.z[group.begin];
+        float4 *v = &_vertices[mc.vertex_offset + group.begin];
+
+#ifdef __SSE2__
+        const __m128 r00 = _mm_set1_ps(T.r0.x), r01 = _mm_set1_ps(T.r0.y), r02 = _mm_set1_ps(T.r0.z), t0 = _mm_set1_ps(T.r0.w);
+        const __m128 r10 = _mm_set1_ps(T.r1.x), r11 = _mm_set1_ps(T.r1.y), r12 = _mm_set1_ps(T.r1.z), t1 = _mm_set1_ps(T.r1.w);
+        const __m128 r20 = _mm_set1_ps(T.r2.x), r21 = _mm_set1_ps(T.r2.y), r22 = _mm_set1_ps(T.r2.z), t2 = _mm_set1_ps(T.r2.w);
+        for(size_t i=0; i<group.size; i+=4) {
+            const __m128 px = _mm_loadu_ps(x+i);
+            const __m128 py = _mm_loadu_ps(y+i);
+            const __m128 pz = _mm_loadu_ps(z+i);
+            __m128 qx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r00, px), _mm_mul_ps(r01, py)), _mm_add_ps(_mm_mul_ps(r02, pz), t0));
+            __m128 qy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r10, px), _mm_mul_ps(r11, py)), _mm_add_ps(_mm_mul_ps(r12, pz), t1));
+            __m128 qz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r20, px), _mm_mul_ps(r21, py)), _mm_add_ps(_mm_mul_ps(r22, pz), t2));
+            __m128 qw = _mm_set1_ps(1);
+            // structure of arrays to homogeneous vertices
+            _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+            _mm_storeu_ps(&v[i].x, qx);
+            _mm_storeu_ps(&v[i+1].x, qy);
+            _mm_storeu_ps(&v[i+2].x, qz);
+            _mm_storeu_ps(&v[i+3].x, qw);
+        }
+#else
+        for(size_t i=0; i<group.size; i++) {
+            v[i].x = T.r0.x*x[i] + T.r0.y*y[i] + T.r0.z*z[i] + T.r0.w;
+            v[i].y = T.r1.x*x[i] + T.r1.y*y[i] + T.r1.z*z[i] + T.r1.w;
+            v[i].z = T.r2.x*x[i] + T.r2.y*y[i] + T.r2.z*z[i] + T.r2.w;
+            v[i].w = 1;
+        }
+#endif
+    }
+    _uploaded = false;
+}
+
+void dart::CollisionCloudBatch::draw() {
+    if(_vertices.empty())
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    if(!_uploaded) {
+        const size_t bytes = _vertices.size()*sizeof(float4);
+        _vbo_capacity = std::max(_vbo_capacity, bytes);
+        // orphan the vertices of the previous frame, the GL may still draw from them
+        glBufferData(GL_ARRAY_BUFFER, _vbo_capacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, _vertices.data());
+        _uploaded = true;
+    }
+
+    glVertexPointer(4, GL_FLOAT, 0, 0);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glDrawArrays(GL_POINTS, 0, _vertices.size());
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
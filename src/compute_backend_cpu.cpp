@@ -0,0 +1,82 @@
+#include <compute_backend.hpp>
+#include <host_image_ops.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace {
+
+// pixels per chunk of the parallel image loops, a multiple of the SIMD width
+const int chunk = 4096;
+
+}
+
+void dart::backend::initialise(const int /*device*/) {
+#ifdef _OPENMP
+    std::cout<<"host backend with "<<omp_get_max_threads()<<" OpenMP threads"<<std::endl;
+#else
+    std::cout<<"host backend without OpenMP, single-threaded"<<std::endl;
+#endif
+}
+
+const char * dart::backend::name() {
+    return "CPU";
+}
+
+void * dart::backend::deviceAlloc(const size_t bytes) {
+    // device memory is host memory
+    void *ptr = NULL;
+    if(posix_memalign(&ptr, 64, bytes)!=0)
+        return NULL;
+    return ptr;
+}
+
+void dart::backend::deviceFree(void *ptr) {
+    std::free(ptr);
+}
+
+void dart::backend::copyToHost(void *dst, const void *src, const size_t bytes) {
+    // device pointers are host pointers
+    if(dst!=src)
+        std::memcpy(dst, src, bytes);
+}
+
+void dart::backend::colorRampHeatMap(uchar3 *img, const float *values, const int width, const int height, const float min, const float max) {
+    const int size = width*height;
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<size; i+=chunk)
+        host::heatMap(img+i, values+i, std::min(chunk, size-i), min, max);
+}
+
+void dart::backend::colorSquaredRampHeatMap(uchar3 *img, const float *values, const int width, const int height, const float min, const float max, float * /*scratch*/) {
+    // squaring is fused into the coloring, scratch is not needed
+    const int size = width*height;
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<size; i+=chunk)
+        host::heatMap(img+i, values+i, std::min(chunk, size-i), min, max, true);
+}
+
+void dart::backend::colorDataAssociation(uchar3 *img, const int *association, const uchar3 * const *sdfColors, const int width, const int height) {
+    const int size = width*height;
+    #pragma omp parallel for schedule(static)
+    for(int i=0; i<size; i++) {
+        const int a = association[i];
+        if(a<0) {
+            img[i].x = img[i].y = img[i].z = 0;
+            continue;
+        }
+        // association encodes model in the upper and SDF in the lower 16 bit
+        img[i] = sdfColors[a >> 16][a & 0xffff];
+    }
+}
+
+bool dart::backend::checkLastError() {
+    // host operations report errors synchronously
+    return true;
+}
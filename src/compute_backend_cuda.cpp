@@ -0,0 +1,55 @@
+#include <compute_backend.hpp>
+
+#include <cuda_runtime.h>
+
+#include <dart/img_proc/img_ops.h>
+#include <dart/visualization/color_ramps.h>
+#include <dart/visualization/data_association_viz.h>
+
+#include <iostream>
+
+void dart::backend::initialise(const int device) {
+    cudaSetDevice(device);
+    cudaDeviceReset();
+}
+
+const char * dart::backend::name() {
+    return "CUDA";
+}
+
+void * dart::backend::deviceAlloc(const size_t bytes) {
+    void *ptr = NULL;
+    if(cudaMalloc(&ptr, bytes)!=cudaSuccess)
+        return NULL;
+    return ptr;
+}
+
+void dart::backend::deviceFree(void *ptr) {
+    cudaFree(ptr);
+}
+
+void dart::backend::copyToHost(void *dst, const void *src, const size_t bytes) {
+    cudaMemcpy(dst, src, bytes, cudaMemcpyDeviceToHost);
+}
+
+void dart::backend::colorRampHeatMap(uchar3 *img, const float *values, const int width, const int height, const float min, const float max) {
+    dart::colorRampHeatMapUnsat(img, values, width, height, min, max);
+}
+
+void dart::backend::colorSquaredRampHeatMap(uchar3 *img, const float *values, const int width, const int height, const float min, const float max, float *scratch) {
+    dart::imageSquare(scratch, values, width, height);
+    dart::colorRampHeatMapUnsat(img, scratch, width, height, min, max);
+}
+
+void dart::backend::colorDataAssociation(uchar3 *img, const int *association, const uchar3 * const *sdfColors, const int width, const int height) {
+    dart::colorDataAssociationMultiModel(img, association, const_cast<const uchar3 **>(sdfColors), width, height);
+}
+
+bool dart::backend::checkLastError() {
+    const cudaError_t err = cudaGetLastError();
+    if (err != cudaSuccess) {
+        std::cerr << cudaGetErrorString(err) << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,86 @@
+#include <frame_arena.hpp>
+
+#include <compute_backend.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace {
+
+size_t align(const size_t bytes) {
+    return (bytes + dart::FrameArena::Alignment-1) / dart::FrameArena::Alignment * dart::FrameArena::Alignment;
+}
+
+void * allocateMemory(const size_t bytes, const bool device) {
+    if(device)
+        return dart::backend::deviceAlloc(bytes);
+    void *ptr = NULL;
+    if(posix_memalign(&ptr, dart::FrameArena::Alignment, bytes)!=0)
+        return NULL;
+    return ptr;
+}
+
+void freeMemory(void *ptr, const bool device) {
+    if(device)
+        dart::backend::deviceFree(ptr);
+    else
+        std::free(ptr);
+}
+
+}
+
+dart::FrameArena::FrameArena(const size_t host_bytes, const size_t device_bytes) {
+    _host.capacity = align(host_bytes);
+    _device.capacity = align(device_bytes);
+    if(_host.capacity>0)
+        _host.base = static_cast<unsigned char*>(allocateMemory(_host.capacity, false));
+    if(_device.capacity>0)
+        _device.base = static_cast<unsigned char*>(allocateMemory(_device.capacity, true));
+    if(_host.base==NULL)
+        _host.capacity = 0;
+    if(_device.base==NULL)
+        _device.capacity = 0;
+}
+
+dart::FrameArena::~FrameArena() {
+    release(_host, false);
+    release(_device, true);
+    freeMemory(_host.base, false);
+    freeMemory(_device.base, true);
+}
+
+void * dart::FrameArena::allocate(Region &region, const size_t bytes, const bool device) {
+    const size_t size = align(bytes);
+    const size_t offset = region.used;
+    region.used += size;
+    if(region.used<=region.capacity)
+        return region.base + offset;
+
+    if(!region.warned) {
+        std::cerr<<"frame arena: "<<(device ? "device" : "host")<<" scratch of "<<region.capacity
+                 <<" bytes is too small for "<<region.used<<" bytes, allocating per frame"<<std::endl;
+        region.warned = true;
+    }
+    region.overflows++;
+    void *ptr = allocateMemory(size, device);
+    region.overflow.push_back(ptr);
+    return ptr;
+}
+
+void dart::FrameArena::release(Region &region, const bool device) {
+    for(size_t i=0; i<region.overflow.size(); i++)
+        freeMemory(region.overflow[i], device);
+    region.overflow.clear();
+}
+
+void dart::FrameArena::endFrame() {
+    _host.frame_peak = _host.used;
+    _device.frame_peak = _device.used;
+    _host.peak = std::max(_host.peak, _host.used);
+    _device.peak = std::max(_device.peak, _device.used);
+    _host.used = 0;
+    _device.used = 0;
+    release(_host, false);
+    release(_device, true);
+}
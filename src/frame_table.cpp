@@ -0,0 +1,186 @@
+#include <frame_table.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char magic[4] = {'D','F','T','B'};
+const uint32_t version = 1;
+const uint64_t alignment = 64;
+
+uint64_t align(const uint64_t offset) {
+    return (offset + alignment-1) / alignment * alignment;
+}
+
+// offset+count*size <= limit, without overflow of the product or the sum
+bool fits(const uint64_t offset, const uint64_t count, const uint64_t size, const uint64_t limit) {
+    if(offset>limit)
+        return false;
+    return size==0 || count<=(limit-offset)/size;
+}
+
+void pad(std::ofstream &ofs, const uint64_t offset) {
+    static const char zeros[alignment] = {0};
+    const uint64_t pos = ofs.tellp();
+    ofs.write(zeros, offset-pos);
+}
+
+template<typename T>
+bool convertValues(std::ifstream &ifs, std::ofstream &ofs, const uint64_t frames, const uint32_t columns) {
+    // convert frame by frame, so that memory does not grow with the sequence length
+    std::vector<T> values(columns);
+    for(uint64_t f=0; f<frames; f++) {
+        for(uint32_t c=0; c<columns; c++) {
+            if(!(ifs >> values[c]))
+                return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(values.data()), columns*sizeof(T));
+    }
+    return true;
+}
+
+}
+
+dart::MappedFrameTable::MappedFrameTable() : _map(NULL), _size(0), _header(NULL) { }
+
+dart::MappedFrameTable::~MappedFrameTable() {
+    close();
+}
+
+bool dart::MappedFrameTable::open(const std::string &file) {
+    close();
+
+    const int fd = ::open(file.c_str(), O_RDONLY);
+    if(fd<0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st)!=0 || size_t(st.st_size)<sizeof(FrameTableHeader)) {
+        ::close(fd);
+        std::cerr<<file<<" is not a frame table"<<std::endl;
+        return false;
+    }
+
+    // the mapping keeps the file referenced after closing the descriptor
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(map==MAP_FAILED) {
+        std::cerr<<"cannot map "<<file<<std::endl;
+        return false;
+    }
+    _map = map;
+    _size = st.st_size;
+
+    const FrameTableHeader *header = static_cast<const FrameTableHeader*>(_map);
+    const uint64_t value_size = 4;
+    const bool valid = std::memcmp(header->magic, magic, sizeof(magic))==0 && header->version==version &&
+            (header->type==FrameTableHeader::Float32 || header->type==FrameTableHeader::Int32) &&
+            header->stride>=header->columns*value_size &&
+            (header->timestamps_offset==0 || fits(header->timestamps_offset, header->frames, sizeof(int64_t), _size)) &&
+            fits(header->data_offset, header->frames, header->stride, _size);
+    if(!valid) {
+        std::cerr<<file<<" is not a valid frame table"<<std::endl;
+        close();
+        return false;
+    }
+    _header = header;
+    return true;
+}
+
+void dart::MappedFrameTable::close() {
+    if(_map!=NULL)
+        munmap(_map, _size);
+    _map = NULL;
+    _size = 0;
+    _header = NULL;
+}
+
+const int64_t * dart::MappedFrameTable::timestamps() const {
+    if(_header==NULL || _header->timestamps_offset==0)
+        return NULL;
+    return reinterpret_cast<const int64_t*>(static_cast<const char*>(_map) + _header->timestamps_offset);
+}
+
+dart::StridedView<float> dart::MappedFrameTable::floats() const {
+    if(_header==NULL || _header->type!=FrameTableHeader::Float32)
+        return StridedView<float>();
+    return StridedView<float>(static_cast<const char*>(_map) + _header->data_offset, _header->frames, _header->columns, _header->stride);
+}
+
+dart::StridedView<int> dart::MappedFrameTable::ints() const {
+    if(_header==NULL || _header->type!=FrameTableHeader::Int32)
+        return StridedView<int>();
+    return StridedView<int>(static_cast<const char*>(_map) + _header->data_offset, _header->frames, _header->columns, _header->stride);
+}
+
+bool dart::convertFrameTableText(const std::string &text_file, const std::string &binary_file,
+                                 const FrameTableHeader::ValueType type, const int columns,
+                                 const std::string &timestamp_file) {
+    std::ifstream ifs(text_file.c_str());
+    if(!ifs) {
+        std::cerr<<"cannot read "<<text_file<<std::endl;
+        return false;
+    }
+
+    int64_t frames = 0;
+    int64_t cols = columns;
+    if(!(ifs >> frames) || (columns==0 && !(ifs >> cols)) || frames<0 || cols<=0) {
+        std::cerr<<text_file<<": invalid table size"<<std::endl;
+        return false;
+    }
+
+    std::vector<int64_t> timestamps;
+    if(!timestamp_file.empty()) {
+        std::ifstream tfs(timestamp_file.c_str());
+        int64_t t;
+        while(tfs >> t)
+            timestamps.push_back(t);
+        if(int64_t(timestamps.size())!=frames) {
+            std::cerr<<timestamp_file<<": expected "<<frames<<" timestamps, got "<<timestamps.size()<<std::endl;
+            return false;
+        }
+    }
+
+    FrameTableHeader header;
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.type = type;
+    header.columns = cols;
+    header.frames = frames;
+    header.stride = cols*4;
+    header.timestamps_offset = timestamps.empty() ? 0 : align(sizeof(FrameTableHeader));
+    header.data_offset = align(timestamps.empty() ? sizeof(FrameTableHeader) : header.timestamps_offset + frames*sizeof(int64_t));
+
+    // write to temporary file first, so that an interrupted conversion leaves no truncated table
+    const std::string tmp_file = binary_file + ".tmp";
+    std::ofstream ofs(tmp_file.c_str(), std::ios::binary);
+    if(!ofs) {
+        std::cerr<<"cannot write "<<tmp_file<<std::endl;
+        return false;
+    }
+    ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if(!timestamps.empty()) {
+        pad(ofs, header.timestamps_offset);
+        ofs.write(reinterpret_cast<const char*>(timestamps.data()), timestamps.size()*sizeof(int64_t));
+    }
+    pad(ofs, header.data_offset);
+
+    const bool parsed = (type==FrameTableHeader::Float32) ? convertValues<float>(ifs, ofs, frames, cols)
+                                                          : convertValues<int32_t>(ifs, ofs, frames, cols);
+    ofs.close();
+    if(!parsed || !ofs) {
+        std::cerr<<text_file<<": "<<(parsed ? "cannot write table" : "fewer values than frames*columns")<<std::endl;
+        std::remove(tmp_file.c_str());
+        return false;
+    }
+    return std::rename(tmp_file.c_str(), binary_file.c_str())==0;
+}
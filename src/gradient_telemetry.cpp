@@ -0,0 +1,137 @@
+#include <gradient_telemetry.hpp>
+
+#include <dart_lcm/lcm_provider_base.hpp>
+
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+int64_t nowMicroseconds() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+dart::LCMGradientSink::LCMGradientSink(const std::string &channel) : _channel(channel) { }
+
+void dart::LCMGradientSink::publish(const int64_t utime, const std::vector<std::string> &names, const std::vector<float> &values) {
+    _msg.utime = utime;
+    _msg.num_joints = names.size();
+    _msg.joint_name = names;
+    _msg.joint_position = values;
+    LCM_CommonBase::publish(_channel, &_msg);
+}
+
+dart::FileGradientSink::FileGradientSink(const std::string &path) : _file(path), _header(false) {
+    if(!_file.is_open())
+        std::cerr<<"cannot open gradient file "<<path<<std::endl;
+}
+
+void dart::FileGradientSink::publish(const int64_t utime, const std::vector<std::string> &names, const std::vector<float> &values) {
+    if(!_header) {
+        _file<<"utime";
+        for(const std::string &name : names)
+            _file<<","<<name;
+        _file<<"\n";
+        _header = true;
+    }
+    _file<<utime;
+    for(const float v : values)
+        _file<<","<<v;
+    _file<<"\n";
+}
+
+void dart::MemoryGradientSink::publish(const int64_t utime, const std::vector<std::string> &names, const std::vector<float> &values) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _utimes.push_back(utime);
+    _samples.push_back(values);
+}
+
+std::vector<std::vector<float> > dart::MemoryGradientSink::samples() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _samples;
+}
+
+std::vector<int64_t> dart::MemoryGradientSink::utimes() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _utimes;
+}
+
+dart::GradientTelemetry::GradientTelemetry(GradientSink *sink, const Pose &pose, const double rate, const bool filter_fixed, const unsigned int capacity)
+    : _sink(sink), _dims(pose.getReducedArticulatedDimensions()), _capacity(capacity),
+      _head(0), _tail(0), _rate(rate), _dropped(0), _published(0), _running(true)
+{
+    for(int i=0; i<_dims; i++) {
+        // fixed joints have identical lower and upper limits
+        if(filter_fixed && pose.getReducedMin(i)==pose.getReducedMax(i))
+            continue;
+        _selected.push_back(i);
+        _names.push_back(pose.getReducedName(i));
+    }
+
+    _slots.assign(_capacity, std::vector<float>(_dims));
+    _slot_utimes.assign(_capacity, 0);
+
+    _thread = std::thread(&GradientTelemetry::run, this);
+}
+
+dart::GradientTelemetry::~GradientTelemetry() {
+    _running = false;
+    if(_thread.joinable())
+        _thread.join();
+}
+
+bool dart::GradientTelemetry::push(const float *values, const int n) {
+    const uint64_t head = _head.load(std::memory_order_relaxed);
+    if(n!=_dims || head - _tail.load(std::memory_order_acquire) >= _capacity) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const unsigned int slot = head % _capacity;
+    std::copy(values, values+n, _slots[slot].begin());
+    _slot_utimes[slot] = nowMicroseconds();
+    _head.store(head+1, std::memory_order_release);
+    return true;
+}
+
+void dart::GradientTelemetry::run() {
+    std::vector<float> values(_selected.size());
+    uint64_t reported_dropped = 0;
+    auto next = std::chrono::steady_clock::now();
+
+    while(_running) {
+        const double rate = _rate;
+        // poll queue if every sample is published
+        next += (rate>0) ? std::chrono::microseconds(int64_t(1e6/rate)) : std::chrono::microseconds(1000);
+        const auto now = std::chrono::steady_clock::now();
+        if(next<now)
+            next = now;
+        std::this_thread::sleep_until(next);
+
+        const uint64_t head = _head.load(std::memory_order_acquire);
+        uint64_t tail = _tail.load(std::memory_order_relaxed);
+        if(head==tail)
+            continue;
+
+        // rate limited: only publish the newest sample
+        if(rate>0)
+            tail = head-1;
+
+        for(; tail<head; tail++) {
+            const unsigned int slot = tail % _capacity;
+            for(unsigned int i=0; i<_selected.size(); i++)
+                values[i] = _slots[slot][_selected[i]];
+            _sink->publish(_slot_utimes[slot], _names, values);
+            _published++;
+        }
+        _tail.store(head, std::memory_order_release);
+
+        const uint64_t dropped = _dropped;
+        if(dropped!=reported_dropped) {
+            std::cerr<<"gradient telemetry: dropped "<<(dropped-reported_dropped)<<" samples"<<std::endl;
+            reported_dropped = dropped;
+        }
+    }
+}
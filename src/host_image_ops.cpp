@@ -0,0 +1,142 @@
+#include <host_image_ops.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// color packed as 0x00zzyyxx, i.e. in the byte order of uchar3
+inline uint32_t pack(const uchar3 c) {
+    return uint32_t(c.x) | uint32_t(c.y)<<8 | uint32_t(c.z)<<16;
+}
+
+inline uchar3 unpack(const uint32_t c) {
+    uchar3 u;
+    u.x = c & 0xff;
+    u.y = (c >> 8) & 0xff;
+    u.z = (c >> 16) & 0xff;
+    return u;
+}
+
+// store 4 packed colors as 12 bytes with three 32 bit words instead of 12 byte stores
+inline void store4(uchar3 *img, const uint32_t c[4]) {
+    const uint32_t w[3] = { c[0] | c[1]<<24, c[1]>>8 | c[2]<<16, c[2]>>16 | c[3]<<8 };
+    std::memcpy(img, w, sizeof(w));
+}
+
+inline uint32_t grayScalar(const float d, const float scale, const float offset, const uint32_t invalid) {
+    if(d==0)
+        return invalid;
+    const uint32_t g = std::max(0.f, std::min(d*scale+offset, 255.f));
+    return g * 0x010101;
+}
+
+inline uint32_t heatScalar(const float v, const float min, const float max) {
+    if(!(v>=min && v<=max))
+        return 0;
+    // piecewise linear ramp over s in [0,4]: blue, cyan, green, yellow, red
+    const float s = 4*(v-min)/(max-min);
+    const uint32_t r = std::max(0.f, std::min(255*(s-2), 255.f));
+    const uint32_t g = std::max(0.f, std::min(std::min(255*s, 255*(4-s)), 255.f));
+    const uint32_t b = std::max(0.f, std::min(255*(2-s), 255.f));
+    return r | g<<8 | b<<16;
+}
+
+#ifdef __SSE2__
+
+inline __m128 load4(const float *p, const size_t stride) {
+    if(stride==1)
+        return _mm_loadu_ps(p);
+    return _mm_setr_ps(p[0], p[stride], p[2*stride], p[3*stride]);
+}
+
+inline __m128 load4(const unsigned short *p, const size_t stride) {
+    __m128i v;
+    if(stride==1)
+        v = _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), _mm_setzero_si128());
+    else
+        v = _mm_setr_epi32(p[0], p[stride], p[2*stride], p[3*stride]);
+    return _mm_cvtepi32_ps(v);
+}
+
+// truncate values in [0,255] to bytes in the lower 8 bit of each lane
+inline __m128i toByte(const __m128 v) {
+    return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(255)));
+}
+
+#endif
+
+}
+
+template<typename DepthType>
+void dart::host::depthToGray(uchar3 *img, const DepthType *depth, const size_t size, const float scaleToMeters,
+                             const float min, const float max, const uchar3 invalid, const size_t stride) {
+    // gray = 255*(d*scaleToMeters-min)/(max-min) = d*scale + offset
+    const float scale = 255*scaleToMeters/(max-min);
+    const float offset = -255*min/(max-min);
+    const uint32_t invalid_color = pack(invalid);
+
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 s = _mm_set1_ps(scale);
+    const __m128 o = _mm_set1_ps(offset);
+    const __m128i inv = _mm_set1_epi32(invalid_color);
+    for(; i+4<=size; i+=4) {
+        const __m128 d = load4(depth + i*stride, stride);
+        const __m128i g = toByte(_mm_add_ps(_mm_mul_ps(d, s), o));
+        const __m128i gray = _mm_or_si128(_mm_or_si128(g, _mm_slli_epi32(g, 8)), _mm_slli_epi32(g, 16));
+        const __m128i mask = _mm_castps_si128(_mm_cmpeq_ps(d, _mm_setzero_ps()));
+        const __m128i c = _mm_or_si128(_mm_and_si128(mask, inv), _mm_andnot_si128(mask, gray));
+
+        uint32_t colors[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(colors), c);
+        store4(img+i, colors);
+    }
+#endif
+    for(; i<size; i++)
+        img[i] = unpack(grayScalar(depth[i*stride], scale, offset, invalid_color));
+}
+
+void dart::host::heatMap(uchar3 *img, const float *values, const size_t size, const float min, const float max,
+                         const bool squared) {
+    size_t i = 0;
+#ifdef __SSE2__
+    const __m128 lo = _mm_set1_ps(min);
+    const __m128 hi = _mm_set1_ps(max);
+    const __m128 scale = _mm_set1_ps(4/(max-min));
+    const __m128 c255 = _mm_set1_ps(255);
+    const __m128 c2 = _mm_set1_ps(2);
+    const __m128 c4 = _mm_set1_ps(4);
+    for(; i+4<=size; i+=4) {
+        __m128 v = _mm_loadu_ps(values+i);
+        if(squared)
+            v = _mm_mul_ps(v, v);
+        // compares are false for NaN, i.e. NaN is black like out of range values
+        const __m128i in_range = _mm_castps_si128(_mm_and_ps(_mm_cmpge_ps(v, lo), _mm_cmple_ps(v, hi)));
+        const __m128 s = _mm_mul_ps(_mm_sub_ps(v, lo), scale);
+
+        const __m128i r = toByte(_mm_mul_ps(c255, _mm_sub_ps(s, c2)));
+        const __m128i g = toByte(_mm_mul_ps(c255, _mm_min_ps(s, _mm_sub_ps(c4, s))));
+        const __m128i b = toByte(_mm_mul_ps(c255, _mm_sub_ps(c2, s)));
+        const __m128i c = _mm_and_si128(in_range, _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)), _mm_slli_epi32(b, 16)));
+
+        uint32_t colors[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(colors), c);
+        store4(img+i, colors);
+    }
+#endif
+    for(; i<size; i++) {
+        const float v = squared ? values[i]*values[i] : values[i];
+        img[i] = unpack(heatScalar(v, min, max));
+    }
+}
+
+template void dart::host::depthToGray<unsigned short>(uchar3 *, const unsigned short *, const size_t, const float,
+                                                      const float, const float, const uchar3, const size_t);
+template void dart::host::depthToGray<float>(uchar3 *, const float *, const size_t, const float,
+                                             const float, const float, const uchar3, const size_t);
@@ -0,0 +1,97 @@
+#include <iteration_policy.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double milliseconds(const std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}
+
+const char * dart::IterationPolicy::stopReasonName(const StopReason reason) {
+    switch(reason) {
+    case MaxIterations:   return "max iterations";
+    case Converged:       return "converged";
+    case ErrorStalled:    return "error stalled";
+    case BudgetExhausted: return "budget exhausted";
+    case NotOptimized:    return "not optimized";
+    default:              return "unknown";
+    }
+}
+
+dart::IterationPolicy::IterationPolicy(const int max_iterations, const float min_update, const float min_error_change, const double budget)
+    : _max_iterations(max_iterations), _min_update(min_update), _min_error_change(min_error_change), _budget(budget),
+      _max_iteration_time(0), _error(0), _update(0), _iterations(0), _reason(MaxIterations) { }
+
+bool dart::IterationPolicy::beginFrame(const float *params, const int n) {
+    _frame_start = _iteration_start = Clock::now();
+    _params.assign(params, params+n);
+    _update = 0;
+    _iterations = 0;
+    _reason = MaxIterations;
+    return _max_iterations>0;
+}
+
+bool dart::IterationPolicy::endIteration(const float *params, const float error) {
+    const Clock::time_point now = Clock::now();
+    const double iteration_time = milliseconds(now-_iteration_start);
+    _iteration_start = now;
+    // iterations of previous frames predict the time of the next iteration, the
+    // estimate decays slowly so that a single slow iteration does not stall the budget
+    _max_iteration_time = std::max(iteration_time, 0.95*_max_iteration_time);
+
+    float sq_update = 0;
+    for(size_t i=0; i<_params.size(); i++) {
+        const float d = params[i]-_params[i];
+        sq_update += d*d;
+        _params[i] = params[i];
+    }
+    _update = std::sqrt(sq_update);
+
+    const float error_change = (_iterations>0 && _error>0) ? std::abs(_error-error)/_error : -1;
+    _error = error;
+    _iterations++;
+
+    if(_iterations>=_max_iterations) {
+        _reason = MaxIterations;
+        return false;
+    }
+    if(_update<_min_update) {
+        _reason = Converged;
+        return false;
+    }
+    if(error_change>=0 && error_change<_min_error_change) {
+        _reason = ErrorStalled;
+        return false;
+    }
+    if(_budget>0 && elapsed()+_max_iteration_time>_budget) {
+        _reason = BudgetExhausted;
+        return false;
+    }
+    return true;
+}
+
+void dart::IterationPolicy::endIterations(const float *params, const float error) {
+    const Clock::time_point now = Clock::now();
+    _max_iteration_time = std::max(milliseconds(now-_iteration_start)/_max_iterations, 0.95*_max_iteration_time);
+    _iteration_start = now;
+
+    // update of the whole frame
+    float sq_update = 0;
+    for(size_t i=0; i<_params.size(); i++) {
+        const float d = params[i]-_params[i];
+        sq_update += d*d;
+        _params[i] = params[i];
+    }
+    _update = std::sqrt(sq_update);
+    _error = error;
+    _iterations = _max_iterations;
+    _reason = MaxIterations;
+}
+
+double dart::IterationPolicy::elapsed() const {
+    return milliseconds(Clock::now()-_frame_start);
+}
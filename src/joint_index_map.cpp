@@ -0,0 +1,97 @@
+#include <joint_index_map.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+
+dart::JointIndexMap::JointIndexMap()
+    : _src_is_pose(false), _num_mapped(0) { }
+
+bool dart::JointIndexMap::sameLayout(const Pose &pose, const std::vector<std::string> &names) {
+    // compare names instead of their addresses, a new reduction may reuse the memory of the old one
+    const int dims = pose.getReducedArticulatedDimensions();
+    if(dims!=int(names.size()))
+        return false;
+    for(int i=0; i<dims; i++) {
+        if(pose.getReducedName(i)!=names[i])
+            return false;
+    }
+    return true;
+}
+
+void dart::JointIndexMap::storeLayout(const Pose &pose, std::vector<std::string> &names) {
+    names.resize(pose.getReducedArticulatedDimensions());
+    for(size_t i=0; i<names.size(); i++) {
+        names[i] = pose.getReducedName(i);
+    }
+}
+
+void dart::JointIndexMap::reset(const int dst_dims) {
+    _index.assign(dst_dims, -1);
+    _min.resize(dst_dims);
+    _max.resize(dst_dims);
+    _num_mapped = 0;
+}
+
+bool dart::JointIndexMap::update(const Pose &src, const Pose &dst) {
+    const int src_dims = src.getReducedArticulatedDimensions();
+    const int dst_dims = dst.getReducedArticulatedDimensions();
+
+    if(_src_is_pose && sameLayout(src, _src_names) && sameLayout(dst, _dst_names))
+        return false;
+
+    std::unordered_map<std::string, int> src_ids;
+    for(int i=0; i<src_dims; i++) {
+        src_ids[src.getReducedName(i)] = i;
+    }
+
+    reset(dst_dims);
+    for(int i=0; i<dst_dims; i++) {
+        const auto it = src_ids.find(dst.getReducedName(i));
+        if(it==src_ids.end())
+            continue;
+        _index[i] = it->second;
+        // apply limits of the source joint
+        _min[i] = src.getReducedMin(it->second);
+        _max[i] = src.getReducedMax(it->second);
+        _num_mapped++;
+    }
+
+    storeLayout(src, _src_names);
+    storeLayout(dst, _dst_names);
+    _src_is_pose = true;
+
+    return true;
+}
+
+void dart::JointIndexMap::build(const std::vector<std::string> &src_names, const Pose &dst) {
+    const int dst_dims = dst.getReducedArticulatedDimensions();
+
+    std::unordered_map<std::string, int> src_ids;
+    for(unsigned int i=0; i<src_names.size(); i++) {
+        src_ids[src_names[i]] = i;
+    }
+
+    reset(dst_dims);
+    for(int i=0; i<dst_dims; i++) {
+        const auto it = src_ids.find(dst.getReducedName(i));
+        if(it==src_ids.end())
+            continue;
+        _index[i] = it->second;
+        // source provides no limits, use limits of the destination joint
+        _min[i] = dst.getReducedMin(i);
+        _max[i] = dst.getReducedMax(i);
+        _num_mapped++;
+    }
+
+    // a name list is not a source pose, force rebuild on next update
+    storeLayout(dst, _dst_names);
+    _src_is_pose = false;
+}
+
+void dart::JointIndexMap::gather(const float *src, float *dst) const {
+    for(unsigned int i=0; i<_index.size(); i++) {
+        if(_index[i]<0)
+            continue;
+        dst[i] = std::min(std::max(src[_index[i]], _min[i]), _max[i]);
+    }
+}
@@ -0,0 +1,34 @@
+#include <joint_state_buffer.hpp>
+
+#include <algorithm>
+
+dart::JointStateBuffer::JointStateBuffer(const std::vector<float> &initial)
+    : _middle(1), _back(0), _front(2)
+{
+    for(Slot &slot : _slots) {
+        slot.values = initial;
+        slot.utime = 0;
+    }
+}
+
+float * dart::JointStateBuffer::beginWrite() {
+    return _slots[_back].values.data();
+}
+
+void dart::JointStateBuffer::commit(const int64_t utime) {
+    _slots[_back].utime = utime;
+    // hand written slot to reader and take over the previously shared slot
+    const uint8_t previous = _middle.exchange(_back | FRESH, std::memory_order_acq_rel);
+    const uint8_t last = _back;
+    _back = previous & ~FRESH;
+    // continue from the latest values, e.g. for joints that are not part of every update
+    std::copy(_slots[last].values.begin(), _slots[last].values.end(), _slots[_back].values.begin());
+}
+
+bool dart::JointStateBuffer::acquire() {
+    if(!(_middle.load(std::memory_order_acquire) & FRESH))
+        return false;
+    // take over the shared slot and hand back the previous reader slot
+    _front = _middle.exchange(_front, std::memory_order_acq_rel) & ~FRESH;
+    return true;
+}
@@ -0,0 +1,62 @@
+#include <lcm_joint_state.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+dart::LCM_JointStateSubscriber::LCM_JointStateSubscriber(const Pose &layout, const std::string &channel, const std::string &provider)
+    : _lcm(provider), _layout(layout), _num_dropped(0),
+      _buffer(std::vector<float>(layout.getReducedArticulation(), layout.getReducedArticulation()+layout.getReducedArticulatedDimensions())),
+      _running(true)
+{
+    if(!_lcm.good()) {
+        std::cerr<<"LCM is not available for channel "<<channel<<std::endl;
+        _running = false;
+        return;
+    }
+
+    _lcm.subscribe(channel, &LCM_JointStateSubscriber::onRobotState, this);
+    _thread = std::thread(&LCM_JointStateSubscriber::run, this);
+}
+
+dart::LCM_JointStateSubscriber::~LCM_JointStateSubscriber() {
+    _running = false;
+    if(_thread.joinable())
+        _thread.join();
+}
+
+void dart::LCM_JointStateSubscriber::run() {
+    while(_running) {
+        // wake up regularly to check for shutdown
+        _lcm.handleTimeout(100);
+    }
+}
+
+void dart::LCM_JointStateSubscriber::onRobotState(const lcm::ReceiveBuffer *rbuf, const std::string &channel, const bot_core::robot_state_t *msg) {
+    write(*msg);
+}
+
+void dart::LCM_JointStateSubscriber::write(const bot_core::robot_state_t &msg) {
+    // malformed message, positions cannot be assigned to joints
+    if(msg.joint_position.size()!=msg.joint_name.size()) {
+        if(_num_dropped++ % 1000 == 0)
+            std::cerr<<"dropping robot state with "<<msg.joint_position.size()<<" positions for "
+                     <<msg.joint_name.size()<<" joints ("<<_num_dropped<<" dropped)"<<std::endl;
+        return;
+    }
+
+    // the joint list of a robot rarely changes between messages, but publishers may
+    // reorder or replace joints without changing their number
+    if(msg.joint_name!=_msg_joint_names) {
+        _joint_map.build(msg.joint_name, _layout);
+        _msg_joint_names = msg.joint_name;
+    }
+
+    _joint_map.gather(msg.joint_position.data(), _buffer.beginWrite());
+    _buffer.commit(msg.utime);
+}
+
+int64_t dart::LCM_JointStateSubscriber::snapshot(Pose &pose) {
+    _buffer.acquire();
+    std::copy(_buffer.values(), _buffer.values()+_buffer.size(), pose.getReducedArticulation());
+    return _buffer.utime();
+}
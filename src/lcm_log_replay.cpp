@@ -0,0 +1,87 @@
+#include <lcm_log_replay.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+dart::LCM_LogReplay::LCM_LogReplay(const std::string &log_file, const std::string &bus, const double speed)
+    : _log(log_file, "r"), _bus(bus), _speed(speed), _frames(0), _failed(false), _first_timestamp(-1), _timestamp(0)
+{
+    if(!_log.good())
+        std::cerr<<"cannot open LCM log "<<log_file<<std::endl;
+    if(!_bus.good())
+        std::cerr<<"LCM replay bus "<<bus<<" is not available"<<std::endl;
+}
+
+std::string dart::LCM_LogReplay::localBus() {
+    // LCM binds with SO_REUSEADDR, a plain bind fails on ports that any LCM instance listens on
+    const int first_port = 20000 + getpid()%20000;
+    for(int i=0; i<20000; i++) {
+        const int port = 20000 + (first_port-20000+i)%20000;
+        const int sock = socket(AF_INET, SOCK_DGRAM, 0);
+        if(sock<0)
+            break;
+        sockaddr_in addr = sockaddr_in();
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        const bool free = bind(sock, reinterpret_cast<sockaddr *>(&addr), sizeof(addr))==0;
+        close(sock);
+        if(free) {
+            std::ostringstream bus;
+            bus<<"udpm://239.255.76.67:"<<port<<"?ttl=0";
+            return bus.str();
+        }
+    }
+    std::cerr<<"no free port for the LCM replay bus"<<std::endl;
+    return std::string();
+}
+
+bool dart::LCM_LogReplay::next(const std::function<bool()> &delivered, const int timeout) {
+    typedef std::chrono::steady_clock Clock;
+
+    if(_failed)
+        return false;
+
+    // events are stored in the order they were received, i.e. by increasing timestamp
+    const lcm::LogEvent *event;
+    while((event = _log.readNextEvent())!=NULL) {
+        if(event->channel==_frame_channel)
+            break;
+        const std::map<std::string, EventHandler>::const_iterator handler = _handlers.find(event->channel);
+        if(handler!=_handlers.end())
+            handler->second(*event);
+    }
+    if(event==NULL)
+        return false;
+
+    if(_first_timestamp<0) {
+        _first_timestamp = event->timestamp;
+        _start = Clock::now();
+    }
+    _timestamp = event->timestamp;
+
+    if(_speed>0) {
+        const std::chrono::microseconds log_time(int64_t((_timestamp-_first_timestamp)/_speed));
+        std::this_thread::sleep_until(_start + log_time);
+    }
+
+    _bus.publish(event->channel, event->data, event->datalen);
+    _frames++;
+
+    // wait until the frame is received, so that no frame is dropped or overtaken
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout);
+    while(!delivered()) {
+        if(Clock::now()>deadline) {
+            std::cerr<<"replayed frame "<<_frames<<" was not delivered within "<<timeout<<" ms"<<std::endl;
+            _failed = true;
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
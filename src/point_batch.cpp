@@ -0,0 +1,80 @@
+#include <point_batch.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+inline dart::PointBatch::Vertex vertex(const float4 &p, const uchar3 c) {
+    dart::PointBatch::Vertex v;
+    v.x = p.x; v.y = p.y; v.z = p.z;
+    v.r = c.x; v.g = c.y; v.b = c.z; v.a = 255;
+    return v;
+}
+
+}
+
+dart::SdfColorTable::SdfColorTable() : _model_offset(1, 0) {
+    _unknown.x = _unknown.y = _unknown.z = 128;
+}
+
+void dart::SdfColorTable::addModel(const std::vector<uchar3> &sdf_colors) {
+    _colors.insert(_colors.end(), sdf_colors.begin(), sdf_colors.end());
+    _model_offset.push_back(_colors.size());
+}
+
+dart::PointBatch::PointBatch(const size_t capacity) : _capacity(capacity), _uploaded(false) {
+    _vertices.reserve(_capacity);
+    glGenBuffers(1, &_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferData(GL_ARRAY_BUFFER, _capacity*sizeof(Vertex), NULL, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+dart::PointBatch::~PointBatch() {
+    glDeleteBuffers(1, &_vbo);
+}
+
+void dart::PointBatch::buildLabelled(const float4 *points, const size_t num_points, const SdfColorTable &colors) {
+    _vertices.clear();
+    const size_t n = std::min(num_points, _capacity);
+    for(size_t i=0; i<n; i++) {
+        if(points[i].z > 0)
+            _vertices.push_back(vertex(points[i], colors.color(int(std::lround(points[i].w)))));
+    }
+    _uploaded = false;
+}
+
+void dart::PointBatch::buildColored(const float4 *points, const uchar3 *colors, const size_t num_points) {
+    _vertices.clear();
+    const size_t n = std::min(num_points, _capacity);
+    for(size_t i=0; i<n; i++) {
+        if(points[i].z > 0)
+            _vertices.push_back(vertex(points[i], colors[i]));
+    }
+    _uploaded = false;
+}
+
+void dart::PointBatch::draw() {
+    if(_vertices.empty())
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    if(!_uploaded) {
+        // orphan the previous batch, the GL may still draw from it
+        glBufferData(GL_ARRAY_BUFFER, _capacity*sizeof(Vertex), NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, _vertices.size()*sizeof(Vertex), _vertices.data());
+        _uploaded = true;
+    }
+
+    glVertexPointer(3, GL_FLOAT, sizeof(Vertex), reinterpret_cast<const GLvoid*>(offsetof(Vertex, x)));
+    glColorPointer(3, GL_UNSIGNED_BYTE, sizeof(Vertex), reinterpret_cast<const GLvoid*>(offsetof(Vertex, r)));
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    glDrawArrays(GL_POINTS, 0, _vertices.size());
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
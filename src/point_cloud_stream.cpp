@@ -0,0 +1,171 @@
+#include <point_cloud_stream.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+const GLbitfield persistent_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+// wait at most this long in ns for the GL to release a segment before checking again
+const GLuint64 fence_timeout = 100000000;
+
+inline const GLvoid * bufferOffset(const size_t offset) {
+    return reinterpret_cast<const GLvoid*>(offset);
+}
+
+}
+
+dart::PointCloudStream::PointCloudStream(const size_t capacity, const bool persistent)
+    : _capacity(capacity), _persistent(persistent && (GLEW_ARB_buffer_storage || GLEW_VERSION_4_4)),
+      _segment(0), _num_indices(0), _uploaded_bytes(0)
+{
+    _element_size[Vertices] = sizeof(float4);
+    _element_size[Normals] = sizeof(float4);
+    _element_size[Colors] = sizeof(uchar3);
+    _element_size[Indices] = sizeof(GLuint);
+    for(int s=0; s<NumStreams; s++) {
+        _mapped[s] = NULL;
+        _uploaded[s] = false;
+        _offset[s] = 0;
+    }
+    for(int i=0; i<NumSegments; i++)
+        _fences[i] = 0;
+
+    createBuffers();
+    std::cout<<"point cloud stream of "<<_capacity<<" points with "
+             <<(_persistent ? "persistently mapped buffers" : "orphaned buffers")<<std::endl;
+}
+
+dart::PointCloudStream::~PointCloudStream() {
+    for(int i=0; i<NumSegments; i++) {
+        if(_fences[i])
+            glDeleteSync(_fences[i]);
+    }
+    for(int s=0; s<NumStreams; s++) {
+        if(_mapped[s]) {
+            glBindBuffer(GL_ARRAY_BUFFER, _buffers[s]);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDeleteBuffers(NumStreams, _buffers);
+}
+
+void dart::PointCloudStream::createBuffers() {
+    glGenBuffers(NumStreams, _buffers);
+
+    for(int s=0; s<NumStreams && _persistent; s++) {
+        const GLsizeiptr size = _capacity*_element_size[s]*NumSegments;
+        glBindBuffer(GL_ARRAY_BUFFER, _buffers[s]);
+        glBufferStorage(GL_ARRAY_BUFFER, size, NULL, persistent_flags);
+        _mapped[s] = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, persistent_flags));
+        if(_mapped[s]==NULL) {
+            std::cerr<<"cannot map point cloud buffer persistently, falling back to orphaning"<<std::endl;
+            for(int m=0; m<s; m++) {
+                glBindBuffer(GL_ARRAY_BUFFER, _buffers[m]);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+                _mapped[m] = NULL;
+            }
+            // storage of buffers is immutable, they have to be recreated
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glDeleteBuffers(NumStreams, _buffers);
+            glGenBuffers(NumStreams, _buffers);
+            _persistent = false;
+        }
+    }
+
+    if(!_persistent) {
+        for(int s=0; s<NumStreams; s++) {
+            glBindBuffer(GL_ARRAY_BUFFER, _buffers[s]);
+            glBufferData(GL_ARRAY_BUFFER, _capacity*_element_size[s], NULL, GL_STREAM_DRAW);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void dart::PointCloudStream::write(const Stream stream, const void *data, const size_t count) {
+    _uploaded[stream] = (data!=NULL);
+    if(data==NULL)
+        return;
+
+    const size_t bytes = std::min(count, _capacity)*_element_size[stream];
+    if(_persistent) {
+        _offset[stream] = _segment*_capacity*_element_size[stream];
+        std::memcpy(_mapped[stream] + _offset[stream], data, bytes);
+    } else {
+        // orphan the storage of the previous frame, which the GL may still draw from
+        _offset[stream] = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, _buffers[stream]);
+        glBufferData(GL_ARRAY_BUFFER, _capacity*_element_size[stream], NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, data);
+    }
+    _uploaded_bytes += bytes;
+}
+
+void dart::PointCloudStream::upload(const float4 *vertices, const float4 *normals, const uchar3 *colors,
+                                    const std::vector<unsigned int> &indices, const size_t num_points) {
+    if(_persistent) {
+        _segment = (_segment+1) % NumSegments;
+        // wait until the GL has drawn from the segment, usually NumSegments-1 frames ago
+        if(_fences[_segment]) {
+            while(glClientWaitSync(_fences[_segment], GL_SYNC_FLUSH_COMMANDS_BIT, fence_timeout)==GL_TIMEOUT_EXPIRED) { }
+            glDeleteSync(_fences[_segment]);
+            _fences[_segment] = 0;
+        }
+    }
+
+    _uploaded_bytes = 0;
+    write(Vertices, vertices, num_points);
+    write(Normals, normals, num_points);
+    write(Colors, colors, num_points);
+    _num_indices = std::min(indices.size(), _capacity);
+    write(Indices, indices.empty() ? NULL : indices.data(), _num_indices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void dart::PointCloudStream::draw() {
+    if(!_uploaded[Vertices] || !_uploaded[Indices])
+        return;
+
+    glBindBuffer(GL_ARRAY_BUFFER, _buffers[Vertices]);
+    glVertexPointer(4, GL_FLOAT, 0, bufferOffset(_offset[Vertices]));
+    glEnableClientState(GL_VERTEX_ARRAY);
+
+    if(_uploaded[Colors]) {
+        glBindBuffer(GL_ARRAY_BUFFER, _buffers[Colors]);
+        glColorPointer(3, GL_UNSIGNED_BYTE, 0, bufferOffset(_offset[Colors]));
+        glEnableClientState(GL_COLOR_ARRAY);
+    } else if(_uploaded[Normals]) {
+        glBindBuffer(GL_ARRAY_BUFFER, _buffers[Normals]);
+        glNormalPointer(GL_FLOAT, sizeof(float4), bufferOffset(_offset[Normals]));
+        glEnableClientState(GL_NORMAL_ARRAY);
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _buffers[Indices]);
+    glDrawElements(GL_POINTS, _num_indices, GL_UNSIGNED_INT, bufferOffset(_offset[Indices]));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+
+    if(_persistent) {
+        if(_fences[_segment])
+            glDeleteSync(_fences[_segment]);
+        _fences[_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void dart::PointCloudStream::compactValidPoints(const float4 *vertices, const size_t num_points, std::vector<unsigned int> &indices) {
+    indices.resize(num_points);
+    size_t n = 0;
+    for(size_t i=0; i<num_points; i++) {
+        // branchless: the index is always written, but only kept for valid points
+        indices[n] = i;
+        n += (vertices[i].z != 0);
+    }
+    indices.resize(n);
+}
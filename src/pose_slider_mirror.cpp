@@ -0,0 +1,104 @@
+#include <pose_slider_mirror.hpp>
+
+#include <cstring>
+
+dart::PoseSliderMirror::PoseSliderMirror() : _slider_changed(false) { }
+
+void dart::PoseSliderMirror::addModel(pangolin::Var<float> * const *vars, const int dims) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Model model;
+    model.offset = _vars.size();
+    model.dims = dims;
+    std::memset(&model.transform, 0, sizeof(model.transform));
+    model.published = false;
+    model.slider_changed = false;
+    _models.push_back(model);
+
+    for(int i=0; i<dims; i++) {
+        _vars.push_back(vars[i]);
+        _published.push_back(vars[i]->Get());
+        _slider_values.push_back(vars[i]->Get());
+        _pending_slot.push_back(-1);
+    }
+    // at most one pending change per slider, so staging never allocates
+    _pending.reserve(_vars.size());
+    _flushing.reserve(_vars.size());
+}
+
+void dart::PoseSliderMirror::stage(const int index, const float value) {
+    _published[index] = value;
+    if(_pending_slot[index]>=0) {
+        _pending[_pending_slot[index]].value = value;
+        return;
+    }
+    _pending_slot[index] = _pending.size();
+    Change change;
+    change.index = index;
+    change.value = value;
+    _pending.push_back(change);
+}
+
+void dart::PoseSliderMirror::publish(const int model, const Pose &pose) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    Model &m = _models[model];
+
+    SE3 T_cm = pose.getTransformModelToCamera();
+    if(!m.published || std::memcmp(&T_cm, &m.transform, sizeof(SE3))!=0) {
+        m.transform = T_cm;
+        const float params[3] = { T_cm.r0.w, T_cm.r1.w, T_cm.r2.w };
+        T_cm.r0.w = T_cm.r1.w = T_cm.r2.w = 0;
+        const se3 t_cm = se3FromSE3(T_cm);
+        for(int i=0; i<3; i++) {
+            if(!m.published || params[i]!=_published[m.offset+i])
+                stage(m.offset+i, params[i]);
+            if(!m.published || t_cm.p[3+i]!=_published[m.offset+3+i])
+                stage(m.offset+3+i, t_cm.p[3+i]);
+        }
+    }
+
+    const float *articulation = pose.getReducedArticulation();
+    for(int i=6; i<m.dims; i++) {
+        if(!m.published || articulation[i-6]!=_published[m.offset+i])
+            stage(m.offset+i, articulation[i-6]);
+    }
+    m.published = true;
+
+    // sliders follow the pose, unless the user moved them since they were last applied
+    if(!m.slider_changed)
+        std::memcpy(&_slider_values[m.offset], &_published[m.offset], m.dims*sizeof(float));
+}
+
+int dart::PoseSliderMirror::flush(const bool visible, const double min_interval) {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if(!visible || std::chrono::duration<double>(now-_last_flush).count() < min_interval)
+        return 0;
+    _last_flush = now;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for(size_t i=0; i<_pending.size(); i++)
+            _pending_slot[_pending[i].index] = -1;
+        _flushing.swap(_pending);
+        _pending.clear();
+    }
+
+    // writing the variables does not need the lock
+    for(size_t i=0; i<_flushing.size(); i++)
+        *_vars[_flushing[i].index] = _flushing[i].value;
+    return _flushing.size();
+}
+
+void dart::PoseSliderMirror::collectSliderChanges(const bool record) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for(size_t m=0; m<_models.size(); m++) {
+        Model &model = _models[m];
+        for(int i=0; i<model.dims; i++) {
+            pangolin::Var<float> &var = *_vars[model.offset+i];
+            if(!var.GuiChanged() || !record)
+                continue;
+            _slider_values[model.offset+i] = var.Get();
+            model.slider_changed = true;
+            _slider_changed = true;
+        }
+    }
+}
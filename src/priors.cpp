@@ -1,16 +1,15 @@
 #include <priors.hpp>
 
-#include <cmath>
-
-// filtering fixed joints delays the prior computation and hence the framerate
-// raise the GRADIENT_SKIP to skip publishing for certain amount of iterations
-// set GRADIENT_SKIP to 0 to obtain all filtered gradients
-#define GRADIENT_SKIP 8
-
-#ifdef LCM_DEBUG_GRADIENT
-#include <dart_lcm/lcm_provider_base.hpp>
-#include <lcmtypes/bot_core/joint_angles_t.hpp>
-#endif
+#include <iostream>
+
+bool dart::GNWorkspace::resize(const int dims) {
+    if(diff.size()==dims && JTJ.rows()==dims)
+        return false;
+    diff.resize(dims);
+    JTe.resize(dims);
+    JTJ.resize(dims, dims);
+    return true;
+}
 
 dart::NoCameraMovementPrior::NoCameraMovementPrior(const int srcModelID) : _srcModelID(srcModelID) {}
 
@@ -22,46 +21,59 @@ void dart::NoCameraMovementPrior::computeContribution(Eigen::SparseMatrix<float>
                              const std::vector<Pose> & poses,
                              const OptimizationOptions & opts)
 {
-    // get offsets for selected model in the full parameter space
-    const Pose & srcPose = poses[_srcModelID];
-    const int srcDims = srcPose.getReducedDimensions();
-    const int srcOffset = modelOffsets[_srcModelID];
-
-    // get step in parameter space at current optimization state
-    Eigen::VectorXf paramUpdate = JTJ.block(srcOffset,srcOffset,srcDims,srcDims).triangularView<Eigen::Upper>().solve(JTe.segment(srcOffset,srcDims));
-
-    // set camera to model transformation (first 6 parameters) to zero
-    paramUpdate.head<6>() = Eigen::VectorXf::Zero(6);
-
-    // compute jacobian and error to achieve no movement of camera frame
-    JTe.segment(srcOffset,srcDims) = JTJ.block(srcOffset,srcOffset,srcDims,srcDims) * paramUpdate;
+    // remove camera to model transformation (first 6 parameters) from the solve
+    _accumulator.freezeParameters(JTJ, JTe, modelOffsets[_srcModelID], 6);
 }
 
 dart::ReportedJointsPrior::ReportedJointsPrior(const int modelID, const Pose &reported, const Pose &current, const double weight)
-    : _modelID(modelID), _reported(reported), _estimated(current), _weight(weight), _Q(Eigen::MatrixXf::Ones(1,1)) {
-#if FILTER_FIXED_JOINTS
+    : _modelID(modelID), _reported(reported), _estimated(current), _weight(weight), _Q(Eigen::MatrixXf::Ones(1,1).sparseView()) {
     setup();
-#endif
 #ifdef DBG_PRINT_JOINTS
     printJointList();
 #endif
 }
 
 dart::ReportedJointsPrior::ReportedJointsPrior(const int modelID, const Pose &reported, const Pose &current, const Eigen::MatrixXf Q)
-    : _modelID(modelID), _reported(reported), _estimated(current), _weight(1.0), _Q(Q) {
-#if FILTER_FIXED_JOINTS
+    : _modelID(modelID), _reported(reported), _estimated(current), _weight(1.0), _Q(Q.sparseView()) {
     setup();
+#ifdef DBG_PRINT_JOINTS
+    printJointList();
 #endif
+}
+
+dart::ReportedJointsPrior::ReportedJointsPrior(const int modelID, const Pose &reported, const Pose &current, const Eigen::SparseMatrix<float> &Q)
+    : _modelID(modelID), _reported(reported), _estimated(current), _weight(1.0), _Q(Q) {
+    setup();
 #ifdef DBG_PRINT_JOINTS
     printJointList();
 #endif
 }
 
-#if FILTER_FIXED_JOINTS
 void dart::ReportedJointsPrior::setup() {
-    _skipped = 0;
+    _telemetry = NULL;
+}
+
+void dart::ReportedJointsPrior::prepare() {
+    // J^T*J of quadratic priors only depends on the joint dimension
+    if(_ws.resize(dims())) {
+        computeJTJ(_ws.JTJ, dims());
+        _ws.JTJ.makeCompressed();
+    }
+}
+
+void dart::ReportedJointsPrior::weightMatrix(Eigen::SparseMatrix<float> &W, const int dims) const {
+    if(_Q.rows()==dims && _Q.cols()==dims) {
+        W = _weight * _Q;
+        return;
+    }
+
+    if(_Q.rows()!=1 || _Q.cols()!=1)
+        std::cerr<<"weight matrix of size "<<_Q.rows()<<"x"<<_Q.cols()<<" does not match "<<dims<<" joints, using scalar weight"<<std::endl;
+
+    W.resize(dims, dims);
+    W.setIdentity();
+    W *= float(_weight);
 }
-#endif
 
 #ifdef DBG_PRINT_JOINTS
 void dart::ReportedJointsPrior::printJointList() {
@@ -73,6 +85,47 @@ void dart::ReportedJointsPrior::printJointList() {
 
 #endif
 
+void dart::ReportedJointsPrior::computeDiff(float *diff) {
+    // resolve reported joints in the order of estimated joints
+    _joint_map.update(_reported, _estimated);
+
+    // compute difference of reported to estimated joint value
+    // joints that are not reported keep their estimated value and have no difference
+    const Eigen::Map<const Eigen::VectorXf> est(_estimated.getReducedArticulation(), dims());
+    Eigen::Map<Eigen::VectorXf> d(diff, dims());
+    d = est;
+    // apply lower and upper joint limits to reported values
+    _joint_map.gather(_reported.getReducedArticulation(), d.data());
+    d -= est;
+
+    // set nan values to 0, e.g. comparison of nan values always yields false
+    d = (d.array()!=d.array()).select(0,d);
+}
+
+void dart::ReportedJointsPrior::publishGradient(const float *JTe) {
+    // serialisation and publishing happen in the telemetry thread
+    if(_telemetry)
+        _telemetry->push(JTe, dims());
+}
+
+void dart::ReportedJointsPrior::addContribution(Eigen::SparseMatrix<float> & fullJTJ,
+                                                Eigen::VectorXf & fullJTe,
+                                                const int * modelOffsets,
+                                                const Eigen::SparseMatrix<float> &JTJ,
+                                                const Eigen::Ref<const Eigen::VectorXf> &JTe)
+{
+    // add prior to articulated parameters of the model, after the 6 transformation parameters
+    const int offset = modelOffsets[_modelID]+6;
+    _accumulator.addBlock(fullJTJ, offset, offset, JTJ);
+    _accumulator.addSegment(fullJTe, offset, JTe);
+}
+
+void dart::ReportedJointsPrior::computeGNParam(GNWorkspace &ws) {
+    // gradient of residual r = W*(est - reported) = -W*diff
+    ws.JTe.noalias() = ws.JTJ*ws.diff;
+    ws.JTe = -ws.JTe;
+}
+
 void dart::ReportedJointsPrior::computeContribution(Eigen::SparseMatrix<float> & fullJTJ,
                              Eigen::VectorXf & fullJTe,
                              const int * modelOffsets,
@@ -81,142 +134,93 @@ void dart::ReportedJointsPrior::computeContribution(Eigen::SparseMatrix<float> &
                              const std::vector<Pose> & poses,
                              const OptimizationOptions & opts)
 {
-    // get mapping of reported joint names and values
-    std::map<std::string, float> rep_map;
-    for(unsigned int i=0; i<_reported.getReducedArticulatedDimensions(); i++) {
-        // apply lower and upper joint limits
-        rep_map[_reported.getReducedName(i)] =
-                std::min(std::max(_reported.getReducedArticulation()[i], _reported.getReducedMin(i)), _reported.getReducedMax(i));
-    }
-
-#ifdef LCM_DEBUG_GRADIENT
-    std::vector<std::string> names;
-#if FILTER_FIXED_JOINTS
-    const bool pub_grad = (_skipped==GRADIENT_SKIP);
-#endif
-#endif
-
-    // compute difference of reported to estimated joint value
-    Eigen::VectorXf diff = Eigen::VectorXf::Zero(_estimated.getReducedArticulatedDimensions());
-    for(unsigned int i=0; i<_estimated.getReducedArticulatedDimensions(); i++) {
-        const std::string jname = _estimated.getReducedName(i);
-#ifdef LCM_DEBUG_GRADIENT
-#if FILTER_FIXED_JOINTS
-        if(pub_grad)
-            if( !(_estimated.getReducedMin(i)==0 && _estimated.getReducedMin(i)==0) )
-#endif
-                names.push_back(jname);
-#endif
-        float rep = rep_map.at(jname);
-        float est = _estimated.getReducedArticulation()[i];
-        diff[i] = rep_map.at(jname) - _estimated.getReducedArticulation()[i];
-    }
-
-    // set nan values to 0, e.g. comparison of nan values always yields false
-    diff = (diff.array()!=diff.array()).select(0,diff);
+    prepare();
+    computeDiff(_ws.diff.data());
 
     // get Gauss-Newton parameter for specific objective function
-    Eigen::MatrixXf J = Eigen::MatrixXf::Zero(_estimated.getReducedArticulatedDimensions(), 1);
-    Eigen::VectorXf JTe = Eigen::VectorXf::Zero(_estimated.getReducedArticulatedDimensions());
-    std::tie(J,JTe) = computeGNParam(diff);
+    computeGNParam(_ws);
 
-    const Eigen::MatrixXf JTJ = J.transpose()*J;
+    publishGradient(_ws.JTe.data());
 
-#ifdef LCM_DEBUG_GRADIENT
-#if FILTER_FIXED_JOINTS
-    if(pub_grad) {
-#endif
-        // publish gradient (JTe)
-        bot_core::joint_angles_t grad;
-        grad.num_joints = names.size();
-        grad.joint_name = names;
-        for(unsigned int i = 0; i<JTe.size(); i++) {
-#if FILTER_FIXED_JOINTS
-            if(!(_estimated.getReducedMin(i)==0 && _estimated.getReducedMin(i)==0))
-#endif
-                grad.joint_position.push_back(JTe[i]);
-        }
-        LCM_CommonBase::publish("DART_GRADIENT", &grad);
-#if FILTER_FIXED_JOINTS
-        _skipped=0;
-    }
-    else {
-        _skipped++;
-    }
-#endif
-#endif // LCM_DEBUG_GRADIENT
-
-    for(unsigned int r=0; r<JTJ.rows(); r++)
-        for(unsigned int c=0; c<JTJ.cols(); c++)
-            if(JTJ(r,c)!=0)
-                fullJTJ.coeffRef(modelOffsets[_modelID]+6+r, modelOffsets[_modelID]+6+c) += JTJ(r,c);
-
-    for(unsigned int r=0; r<JTe.rows(); r++)
-            if(JTe[r]!=0)
-                fullJTe[modelOffsets[_modelID]+6+r] += JTe[r];
+    addContribution(fullJTJ, fullJTe, modelOffsets, _ws.JTJ, _ws.JTe);
 }
 
-std::tuple<Eigen::MatrixXf, Eigen::VectorXf> dart::WeightedL2NormOfError::computeGNParam(const Eigen::VectorXf &diff) {
-    // compute error from joint deviation
-    // error: weighted L2 norm of joint angle difference
-    const float e = _weight * diff.norm();
+void dart::WeightedL2NormOfError::computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const {
+    const float w = _weight;
+    JTJ.resize(dims, dims);
+    JTJ.setIdentity();
+    JTJ *= w*w;
+}
 
-    // Jacobian of error, e.g. the partial derivation of the error w.r.t. to each joint value
-    // For an error of zero, its partial derivative is not defined. Therefore we set its derivative to 0.
-    const Eigen::MatrixXf J = (diff.array()==0).select(0, -_weight * diff.array()/diff.norm());
+void dart::L2NormOfWeightedError::computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const {
+    Eigen::SparseMatrix<float> W;
+    weightMatrix(W, dims);
+    JTJ = Eigen::SparseMatrix<float>(W.transpose()) * W;
+}
 
-    const Eigen::VectorXf JTe = J.array()*e;
-    //const Eigen::VectorXf JTe = - _weight*_weight*diff.transpose();
+void dart::QWeightedError::computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const {
+    Eigen::SparseMatrix<float> Q;
+    weightMatrix(Q, dims);
+    // symmetric part of Q, the antisymmetric part does not contribute to diff^T*Q*diff
+    JTJ = 0.5f * (Eigen::SparseMatrix<float>(Q.transpose()) + Q);
+}
 
-    return std::make_tuple(J, JTe);
+void dart::SimpleWeightedError::computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const {
+    JTJ.resize(dims, dims);
+    JTJ.setIdentity();
 }
 
-std::tuple<Eigen::MatrixXf, Eigen::VectorXf> dart::L2NormOfWeightedError::computeGNParam(const Eigen::VectorXf &diff) {
-    // compute error from joint deviation
-    // error: L2 norm of weighted joint angle difference
-    const float e = (_weight * diff).norm();
+dart::RobustWeightedError::RobustWeightedError(const int modelID, const Pose &reported, const Pose &current, const double weight, const float scale)
+    : ReportedJointsPrior(modelID, reported, current, weight), _scale(scale) {}
 
-    // Jacobian of error, e.g. the partial derivation of the error w.r.t. to each joint value
-    // For an error of zero, its partial derivative is not defined. Therefore we set its derivative to 0.
-    const Eigen::MatrixXf J = (diff.array()==0).select(0, - pow(_weight, 2) * diff.array()/diff.norm());
+dart::RobustWeightedError::RobustWeightedError(const int modelID, const Pose &reported, const Pose &current, const Eigen::MatrixXf Q, const float scale)
+    : ReportedJointsPrior(modelID, reported, current, Q), _scale(scale) {}
 
-    const Eigen::VectorXf JTe = J.array()*e;
+dart::RobustWeightedError::RobustWeightedError(const int modelID, const Pose &reported, const Pose &current, const Eigen::SparseMatrix<float> &Q, const float scale)
+    : ReportedJointsPrior(modelID, reported, current, Q), _scale(scale) {}
 
-    return std::make_tuple(J, JTe);
+void dart::RobustWeightedError::diagonalWeights(Eigen::ArrayXf &q2, const int dims) const {
+    Eigen::SparseMatrix<float> W;
+    weightMatrix(W, dims);
+    q2 = W.diagonal().array().square();
 }
 
-std::tuple<Eigen::MatrixXf, Eigen::VectorXf> dart::QWeightedError::computeGNParam(const Eigen::VectorXf &diff) {
-    // compute error from joint deviation
-    const float e = diff.transpose()*_Q*diff;
-
-    Eigen::MatrixXf deriv = Eigen::MatrixXf::Zero(diff.size(), 1);
+void dart::RobustWeightedError::computeJTJ(Eigen::SparseMatrix<float> &JTJ, const int dims) const {
+    // diagonal pattern with all entries stored, the values are reweighted in place
+    Eigen::ArrayXf q2;
+    diagonalWeights(q2, dims);
+    JTJ.resize(dims, dims);
+    JTJ.reserve(Eigen::VectorXi::Ones(dims));
+    for(int i=0; i<dims; i++)
+        JTJ.insert(i,i) = q2[i];
+}
 
-    for(unsigned int i=0; i<diff.size(); i++) {
-        // original derivation
-        //deriv(i) = diff.dot(_Q.row(i)) + diff.dot(_Q.col(i)) - (diff[i]*_Q(i,i));
-        // negative direction, this works
-        //deriv(i) = - diff.dot(_Q.row(i)) + diff.dot(_Q.col(i)) - (diff[i]*_Q(i,i));
-        deriv(i) = - ( diff.dot(_Q.row(i) + _Q.col(i).transpose()) - (diff[i]*_Q(i,i)) );
+void dart::RobustWeightedError::computeGNParam(GNWorkspace &ws) {
+    const int n = ws.diff.size();
+    if(_q2.size()!=n) {
+        diagonalWeights(_q2, n);
+        _r.resize(n);
+        _omega.resize(n);
     }
 
-    // Jacobian of error, e.g. the partial derivation of the error w.r.t. to each joint value
-    // For an error of zero, its partial derivative is not defined. Therefore we set its derivative to 0.
-    const Eigen::MatrixXf J = (diff.array()==0).select(0, deriv);
+    // weighted residuals and their IRLS weights
+    _r = _q2.sqrt() * ws.diff.array();
+    computeWeights(_r, _scale, _omega);
+    _omega *= _q2;
 
-    const Eigen::VectorXf JTe = J.array()*e;
-
-    return std::make_tuple(J, JTe);
+    // J^T*J = diag(omega*q^2), J^T*r = -omega*q^2*diff
+    Eigen::Map<Eigen::ArrayXf>(ws.JTJ.valuePtr(), n) = _omega;
+    ws.JTe = -(_omega * ws.diff.array()).matrix();
 }
 
-std::tuple<Eigen::MatrixXf, Eigen::VectorXf> dart::SimpleWeightedError::computeGNParam(const Eigen::VectorXf &diff) {
-    // compute error from joint deviation
-    const double e = (_weight*diff).norm();
-
-    // Jacobian of error, e.g. the partial derivation of the error w.r.t. to each joint value
-    // For an error of zero, its partial derivative is not defined. Therefore we set its derivative to 0.
-    const Eigen::MatrixXf J = (diff.array()==0).select(0, -diff.array()/e);
+void dart::HuberWeightedError::computeWeights(const Eigen::ArrayXf &r, const float scale, Eigen::ArrayXf &omega) const {
+    omega = (scale / r.abs()).min(1);
+}
 
-    const Eigen::VectorXf JTe = - diff.transpose();
+void dart::CauchyWeightedError::computeWeights(const Eigen::ArrayXf &r, const float scale, Eigen::ArrayXf &omega) const {
+    omega = (1 + (r/scale).square()).inverse();
+}
 
-    return std::make_tuple(J, JTe);
+void dart::TukeyWeightedError::computeWeights(const Eigen::ArrayXf &r, const float scale, Eigen::ArrayXf &omega) const {
+    omega = (1 - (r/scale).square()).max(0).square();
 }
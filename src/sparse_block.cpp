@@ -0,0 +1,128 @@
+#include <sparse_block.hpp>
+
+#include <algorithm>
+
+namespace {
+
+// range of stored inner indices of a column, valid for compressed and uncompressed storage
+inline void columnRange(const Eigen::SparseMatrix<float> &M, const int col, int &begin, int &end) {
+    begin = M.outerIndexPtr()[col];
+    end = M.isCompressed() ? M.outerIndexPtr()[col+1] : begin + M.innerNonZeroPtr()[col];
+}
+
+}
+
+void dart::SparseBlockAccumulator::insertMissing(Eigen::SparseMatrix<float> &M) {
+    for(const Entry &e : _missing) {
+        M.coeffRef(e.row, e.col) += e.value;
+    }
+    _missing.clear();
+}
+
+void dart::SparseBlockAccumulator::addBlock(Eigen::SparseMatrix<float> &M, const int row, const int col, const Eigen::Ref<const Eigen::MatrixXf> &B) {
+    const int *inner = M.innerIndexPtr();
+    float *values = M.valuePtr();
+
+    for(int c=0; c<B.cols(); c++) {
+        int begin, end;
+        columnRange(M, col+c, begin, end);
+
+        // single search for first row of block, then merge with sorted inner indices
+        int k = std::lower_bound(inner+begin, inner+end, row) - inner;
+        for(int r=0; r<B.rows(); r++) {
+            const float v = B(r,c);
+            if(v==0)
+                continue;
+            while(k<end && inner[k]<row+r)
+                k++;
+            if(k<end && inner[k]==row+r)
+                values[k] += v;
+            else
+                _missing.push_back({row+r, col+c, v});
+        }
+    }
+
+    if(!_missing.empty())
+        insertMissing(M);
+}
+
+void dart::SparseBlockAccumulator::addBlock(Eigen::SparseMatrix<float> &M, const int row, const int col, const Eigen::SparseMatrix<float> &B) {
+    const int *inner = M.innerIndexPtr();
+    float *values = M.valuePtr();
+
+    for(int c=0; c<B.outerSize(); c++) {
+        int begin, end;
+        columnRange(M, col+c, begin, end);
+
+        // both columns are sorted by row, merge them
+        int k = std::lower_bound(inner+begin, inner+end, row) - inner;
+        for(Eigen::SparseMatrix<float>::InnerIterator it(B, c); it; ++it) {
+            const float v = it.value();
+            if(v==0)
+                continue;
+            const int r = row+it.row();
+            while(k<end && inner[k]<r)
+                k++;
+            if(k<end && inner[k]==r)
+                values[k] += v;
+            else
+                _missing.push_back({r, col+c, v});
+        }
+    }
+
+    if(!_missing.empty())
+        insertMissing(M);
+}
+
+void dart::SparseBlockAccumulator::addDiagonal(Eigen::SparseMatrix<float> &M, const int offset, const Eigen::Ref<const Eigen::VectorXf> &d) {
+    const int *inner = M.innerIndexPtr();
+    float *values = M.valuePtr();
+
+    for(int i=0; i<d.size(); i++) {
+        if(d[i]==0)
+            continue;
+        int begin, end;
+        columnRange(M, offset+i, begin, end);
+        const int *it = std::lower_bound(inner+begin, inner+end, offset+i);
+        if(it!=inner+end && *it==offset+i)
+            values[it-inner] += d[i];
+        else
+            _missing.push_back({offset+i, offset+i, d[i]});
+    }
+
+    if(!_missing.empty())
+        insertMissing(M);
+}
+
+void dart::SparseBlockAccumulator::addSegment(Eigen::VectorXf &v, const int offset, const Eigen::Ref<const Eigen::VectorXf> &s) {
+    v.segment(offset, s.size()) += s;
+}
+
+void dart::SparseBlockAccumulator::freezeParameters(Eigen::SparseMatrix<float> &M, Eigen::VectorXf &v, const int offset, const int count) {
+    const int *inner = M.innerIndexPtr();
+    float *values = M.valuePtr();
+
+    // single pass over all stored coefficients
+    for(int c=0; c<M.outerSize(); c++) {
+        int begin, end;
+        columnRange(M, c, begin, end);
+        const bool frozen_col = (c>=offset && c<offset+count);
+        for(int k=begin; k<end; k++) {
+            const int r = inner[k];
+            if(frozen_col || (r>=offset && r<offset+count))
+                values[k] = (r==c) ? 1 : 0;
+        }
+    }
+
+    // diagonal entries that are not stored yet
+    for(int i=offset; i<offset+count; i++) {
+        int begin, end;
+        columnRange(M, i, begin, end);
+        if(!std::binary_search(inner+begin, inner+end, i))
+            _missing.push_back({i, i, 1});
+    }
+    if(!_missing.empty())
+        insertMissing(M);
+
+    v.segment(offset, count).setZero();
+}
@@ -0,0 +1,190 @@
+#include <stage_timer.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+int dart::LatencyHistogram::bucket(const uint64_t us) {
+    if(us<16)
+        return us;
+    // position of highest bit >= 4, followed by 3 bits of mantissa
+    const int e = 63-__builtin_clzll(us);
+    const int sub = (us >> (e-3)) & 7;
+    return 16 + 8*(e-4) + sub;
+}
+
+uint64_t dart::LatencyHistogram::bucketMidpoint(const int b) {
+    if(b<16)
+        return b;
+    const int e = (b-16)/8 + 4;
+    const int sub = (b-16)%8;
+    return ((uint64_t(8+sub)) << (e-3)) + ((uint64_t(1) << (e-3)) >> 1);
+}
+
+dart::LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void dart::LatencyHistogram::record(const uint64_t us) {
+    _buckets[bucket(us)].fetch_add(1, std::memory_order_relaxed);
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(us, std::memory_order_relaxed);
+    uint64_t max = _max.load(std::memory_order_relaxed);
+    while(us>max && !_max.compare_exchange_weak(max, us, std::memory_order_relaxed)) { }
+}
+
+void dart::LatencyHistogram::reset() {
+    for(int b=0; b<NumBuckets; b++)
+        _buckets[b].store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+double dart::LatencyHistogram::mean() const {
+    const uint64_t n = count();
+    return (n>0) ? double(_sum.load(std::memory_order_relaxed))/n : 0;
+}
+
+uint64_t dart::LatencyHistogram::percentile(const double p) const {
+    // count of bucket sum may differ slightly from _count while recording
+    uint64_t total = 0;
+    for(int b=0; b<NumBuckets; b++)
+        total += _buckets[b].load(std::memory_order_relaxed);
+    if(total==0)
+        return 0;
+
+    const uint64_t rank = std::max<uint64_t>(1, uint64_t(p/100*total + 0.5));
+    uint64_t cumulative = 0;
+    for(int b=0; b<NumBuckets; b++) {
+        cumulative += _buckets[b].load(std::memory_order_relaxed);
+        if(cumulative>=rank)
+            return std::min(bucketMidpoint(b), max());
+    }
+    return max();
+}
+
+dart::StageTimers::~StageTimers() {
+    for(LatencyHistogram *h : _histograms)
+        delete h;
+}
+
+int dart::StageTimers::addStage(const std::string &name) {
+    _names.push_back(name);
+    _histograms.push_back(new LatencyHistogram());
+    return _names.size()-1;
+}
+
+void dart::StageTimers::dump(std::ostream &os) const {
+    os << std::left << std::setw(16) << "stage" << std::right
+       << std::setw(10) << "count" << std::setw(10) << "mean" << std::setw(10) << "p50"
+       << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << "  [ms]" << std::endl;
+    os << std::fixed << std::setprecision(3);
+    for(size_t s=0; s<_names.size(); s++) {
+        const LatencyHistogram &h = *_histograms[s];
+        os << std::left << std::setw(16) << _names[s] << std::right
+           << std::setw(10) << h.count()
+           << std::setw(10) << h.mean()/1000
+           << std::setw(10) << h.percentile(50)/1000.0
+           << std::setw(10) << h.percentile(95)/1000.0
+           << std::setw(10) << h.percentile(99)/1000.0
+           << std::setw(10) << h.max()/1000.0 << std::endl;
+    }
+    os.unsetf(std::ios_base::floatfield);
+}
+
+void dart::StageTimers::reset() {
+    for(LatencyHistogram *h : _histograms)
+        h->reset();
+}
+
+dart::StatsServer::StatsServer(StageTimers &timers, const std::string &socket_path, const double interval)
+    : _timers(timers), _socket_path(socket_path), _interval(interval), _socket(-1), _running(true) {
+    if(!_socket_path.empty()) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if(_socket_path.size()>=sizeof(addr.sun_path)) {
+            std::cerr<<"stats socket path too long: "<<_socket_path<<std::endl;
+        }
+        else {
+            std::strcpy(addr.sun_path, _socket_path.c_str());
+            unlink(_socket_path.c_str());
+            _socket = socket(AF_UNIX, SOCK_STREAM, 0);
+            if(_socket<0 || bind(_socket, (sockaddr*)&addr, sizeof(addr))!=0 || listen(_socket, 4)!=0) {
+                std::cerr<<"cannot listen on stats socket "<<_socket_path<<": "<<std::strerror(errno)<<std::endl;
+                if(_socket>=0)
+                    close(_socket);
+                _socket = -1;
+            }
+        }
+    }
+    _thread = std::thread(&StatsServer::run, this);
+}
+
+dart::StatsServer::~StatsServer() {
+    _running = false;
+    _thread.join();
+    if(_socket>=0) {
+        close(_socket);
+        unlink(_socket_path.c_str());
+    }
+}
+
+void dart::StatsServer::run() {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point next_dump = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_interval));
+
+    while(_running) {
+        // wake up regularly to check for shutdown
+        pollfd pfd = {_socket, POLLIN, 0};
+        const int ready = (_socket>=0) ? poll(&pfd, 1, 100) : (usleep(100000), 0);
+        if(ready>0 && (pfd.revents & POLLIN)) {
+            const int client = accept(_socket, NULL, NULL);
+            if(client>=0) {
+                serve(client);
+                close(client);
+            }
+        }
+
+        if(_interval>0 && Clock::now()>=next_dump) {
+            std::ostringstream oss;
+            _timers.dump(oss);
+            std::cout << oss.str() << std::flush;
+            next_dump += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(_interval));
+        }
+    }
+}
+
+void dart::StatsServer::serve(const int client) {
+    // optional command, clients that only read get the statistics right away
+    char cmd[16] = {0};
+    pollfd pfd = {client, POLLIN, 0};
+    if(poll(&pfd, 1, 10)>0 && (pfd.revents & POLLIN)) {
+        const ssize_t n = read(client, cmd, sizeof(cmd)-1);
+        if(n<0)
+            cmd[0] = 0;
+    }
+
+    std::ostringstream oss;
+    _timers.dump(oss);
+    const std::string stats = oss.str();
+    size_t written = 0;
+    while(written<stats.size()) {
+        const ssize_t n = send(client, stats.data()+written, stats.size()-written, MSG_NOSIGNAL);
+        if(n<=0)
+            break;
+        written += n;
+    }
+
+    if(std::strncmp(cmd, "reset", 5)==0)
+        _timers.reset();
+}
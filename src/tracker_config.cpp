@@ -0,0 +1,189 @@
+#include <tracker_config.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+std::string trim(const std::string &s) {
+    const size_t b = s.find_first_not_of(" \t\r");
+    if(b==std::string::npos)
+        return std::string();
+    const size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e-b+1);
+}
+
+template<typename T>
+bool parse(const std::string &value, T &result) {
+    std::istringstream iss(value);
+    T v;
+    if(!(iss >> v) || !(iss >> std::ws).eof())
+        return false;
+    result = v;
+    return true;
+}
+
+bool setMetric(dart::TrackerConfig &config, const std::string &key, const std::string &value) {
+    if(key=="frames")
+        return parse(value, config.frames);
+    else if(key=="latency_ms")
+        return parse(value, config.latencyMean);
+    else if(key=="latency_p95_ms")
+        return parse(value, config.latencyP95);
+    else if(key=="joint_error")
+        return parse(value, config.jointError);
+    else if(key=="iterations")
+        return parse(value, config.iterationsMean);
+    return false;
+}
+
+}
+
+dart::TrackerParameters::TrackerParameters()
+    : itersPerFrame(3), obsSdfSize(64), modelSdfResolution(2e-3), modelSdfPadding(0.07),
+      distanceThreshold(0.035), infoAccumulationRate(0.1),
+      minUpdateNorm(0), minErrorChange(0), frameBudget(0) { }
+
+bool dart::TrackerParameters::set(const std::string &key, const std::string &value) {
+    if(key=="opt.itersPerFrame")
+        return parse(value, itersPerFrame);
+    else if(key=="lim.obsSdfSize")
+        return parse(value, obsSdfSize);
+    else if(key=="lim.modelSdfResolution")
+        return parse(value, modelSdfResolution);
+    else if(key=="lim.modelSdfPadding")
+        return parse(value, modelSdfPadding);
+    else if(key=="opt.distanceThreshold")
+        return parse(value, distanceThreshold);
+    else if(key=="opt.infoAccumulationRate")
+        return parse(value, infoAccumulationRate);
+    else if(key=="opt.minUpdateNorm")
+        return parse(value, minUpdateNorm);
+    else if(key=="opt.minErrorChange")
+        return parse(value, minErrorChange);
+    else if(key=="opt.frameBudget")
+        return parse(value, frameBudget);
+    return false;
+}
+
+void dart::TrackerParameters::write(std::ostream &os) const {
+    os << "opt.itersPerFrame = " << itersPerFrame << std::endl;
+    os << "lim.obsSdfSize = " << obsSdfSize << std::endl;
+    os << "lim.modelSdfResolution = " << modelSdfResolution << std::endl;
+    os << "lim.modelSdfPadding = " << modelSdfPadding << std::endl;
+    os << "opt.distanceThreshold = " << distanceThreshold << std::endl;
+    os << "opt.infoAccumulationRate = " << infoAccumulationRate << std::endl;
+    os << "opt.minUpdateNorm = " << minUpdateNorm << std::endl;
+    os << "opt.minErrorChange = " << minErrorChange << std::endl;
+    os << "opt.frameBudget = " << frameBudget << std::endl;
+}
+
+bool dart::loadTrackerConfigs(const std::string &file, std::vector<TrackerConfig> &configs) {
+    std::ifstream ifs(file.c_str());
+    if(!ifs) {
+        std::cerr<<"cannot read tracker config "<<file<<std::endl;
+        return false;
+    }
+
+    configs.clear();
+    std::string line;
+    for(int l=1; std::getline(ifs, line); l++) {
+        line = trim(line);
+        if(line.empty() || line[0]=='#')
+            continue;
+
+        if(line=="[config]") {
+            configs.push_back(TrackerConfig());
+            continue;
+        }
+
+        const size_t eq = line.find('=');
+        if(eq==std::string::npos) {
+            std::cerr<<file<<":"<<l<<": expected \"key = value\""<<std::endl;
+            return false;
+        }
+        if(configs.empty())
+            configs.push_back(TrackerConfig());
+
+        const std::string key = trim(line.substr(0, eq));
+        const std::string value = trim(line.substr(eq+1));
+        TrackerConfig &config = configs.back();
+        if(!config.params.set(key, value) && !setMetric(config, key, value)) {
+            std::cerr<<file<<":"<<l<<": invalid entry \""<<line<<"\""<<std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool dart::saveTrackerConfigs(const std::string &file, const std::vector<TrackerConfig> &configs, const std::string &comment) {
+    std::ofstream ofs(file.c_str());
+    if(!ofs) {
+        std::cerr<<"cannot write tracker config "<<file<<std::endl;
+        return false;
+    }
+
+    std::istringstream comment_lines(comment);
+    std::string line;
+    while(std::getline(comment_lines, line))
+        ofs << "# " << line << std::endl;
+
+    for(const TrackerConfig &config : configs) {
+        ofs << std::endl << "[config]" << std::endl;
+        if(config.measured()) {
+            ofs << "frames = " << config.frames << std::endl;
+            ofs << "latency_ms = " << config.latencyMean << std::endl;
+            ofs << "latency_p95_ms = " << config.latencyP95 << std::endl;
+            ofs << "joint_error = " << config.jointError << std::endl;
+            if(config.iterationsMean>=0)
+                ofs << "iterations = " << config.iterationsMean << std::endl;
+        }
+        config.params.write(ofs);
+    }
+    return bool(ofs);
+}
+
+std::vector<dart::TrackerConfig> dart::paretoFrontier(const std::vector<TrackerConfig> &configs) {
+    std::vector<TrackerConfig> sorted;
+    for(const TrackerConfig &config : configs) {
+        if(config.measured())
+            sorted.push_back(config);
+    }
+
+    // sweep by increasing latency, ties by increasing error, and keep every configuration
+    // that is more accurate than all faster ones
+    std::sort(sorted.begin(), sorted.end(), [](const TrackerConfig &a, const TrackerConfig &b) {
+        return (a.latencyP95<b.latencyP95) || (a.latencyP95==b.latencyP95 && a.jointError<b.jointError);
+    });
+
+    std::vector<TrackerConfig> frontier;
+    for(const TrackerConfig &config : sorted) {
+        if(frontier.empty() || config.jointError<frontier.back().jointError)
+            frontier.push_back(config);
+    }
+    return frontier;
+}
+
+int dart::selectTrackerConfig(const std::vector<TrackerConfig> &configs, const float budget) {
+    int best = -1;
+    int fastest = -1;
+    for(int i=0; i<int(configs.size()); i++) {
+        const TrackerConfig &c = configs[i];
+        if(!c.measured())
+            continue;
+        if(fastest<0 || c.latencyP95<configs[fastest].latencyP95)
+            fastest = i;
+        if(budget>0 && c.latencyP95>budget)
+            continue;
+        if(best<0 || c.jointError<configs[best].jointError)
+            best = i;
+    }
+    if(best>=0)
+        return best;
+    if(fastest>=0)
+        return fastest;
+    // hand written configurations without measurements
+    return configs.empty() ? -1 : 0;
+}
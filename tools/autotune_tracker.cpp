@@ -0,0 +1,223 @@
+// Offline autotuner for the latency/accuracy parameters of track_manipulation.
+// Each candidate configuration is evaluated by a headless child run of track_manipulation
+// on a recorded sequence, which reports its per-frame latency and the RMS deviation of the
+// tracked from the reported joints. The Pareto frontier of all evaluated configurations is
+// written as config file, to be loaded with "track_manipulation --config FILE [--budget MS]".
+//
+// LCM recordings are best replayed deterministically by track_manipulation itself, e.g.
+//   autotune_tracker --args "--replay sequence.lcmlog" --frames 300
+// Alternatively, an external command can replay the recording during each run, e.g.
+//   autotune_tracker --replay "lcm-logplayer --speed 1 sequence.lcmlog" --frames 300
+// Sequences that are read from disk (ENABLE_JUSTIN) do not need a replay.
+
+#include <tracker_config.hpp>
+
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+void usage(const char *name) {
+    std::fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --exe PATH       track_manipulation executable (default ./track_manipulation)\n"
+        "  --args ARGS      additional arguments of track_manipulation, e.g. \"--replay LOG\"\n"
+        "  --replay CMD     command replaying the recorded sequence during each run\n"
+        "  --frames N       frames per run (default 300)\n"
+        "  --base FILE      configuration to start from (default: built-in defaults)\n"
+        "  --samples N      random search with N candidates (default 32)\n"
+        "  --sweep          sweep each parameter around the base configuration instead\n"
+        "  --seed S         seed of random search (default 0)\n"
+        "  --out FILE       Pareto frontier (default tracker_pareto.cfg)\n", name);
+}
+
+// start shell command, "exec" replaces the shell so that the returned pid is the command itself
+pid_t spawn(const std::string &cmd) {
+    const pid_t pid = fork();
+    if(pid==0) {
+        execl("/bin/sh", "sh", "-c", ("exec "+cmd).c_str(), (char*)NULL);
+        _exit(127);
+    }
+    return pid;
+}
+
+// evaluate configuration by a headless run, returns false if the run failed
+bool evaluate(const std::string &exe, const std::string &args, const std::string &replay, const int frames, dart::TrackerConfig &config) {
+    const std::string candidate_file = "autotune_candidate.cfg";
+    const std::string report_file = "autotune_report.cfg";
+    std::remove(report_file.c_str());
+    if(!dart::saveTrackerConfigs(candidate_file, std::vector<dart::TrackerConfig>(1, config)))
+        return false;
+
+    const pid_t replay_pid = replay.empty() ? -1 : spawn(replay);
+
+    std::ostringstream cmd;
+    cmd << exe << " " << args << " --headless --frames " << frames << " --config " << candidate_file << " --report " << report_file << " > /dev/null";
+    const pid_t tracker_pid = spawn(cmd.str());
+    int status = 0;
+    waitpid(tracker_pid, &status, 0);
+
+    if(replay_pid>0) {
+        kill(replay_pid, SIGTERM);
+        waitpid(replay_pid, NULL, 0);
+    }
+
+    std::vector<dart::TrackerConfig> report;
+    if(!WIFEXITED(status) || WEXITSTATUS(status)!=0 || !dart::loadTrackerConfigs(report_file, report) || report.size()!=1)
+        return false;
+    config = report[0];
+    return true;
+}
+
+std::vector<dart::TrackerParameters> sweep(const dart::TrackerParameters &base) {
+    std::vector<dart::TrackerParameters> candidates;
+    const int iters[] = {1, 2, 3, 5, 8, 12};
+    const int sizes[] = {32, 48, 64, 96, 128};
+    const float scales[] = {0.5f, 0.75f, 1.5f, 2.0f};
+    const float thresholds[] = {0.01f, 0.02f, 0.05f, 0.08f};
+    const float rates[] = {0.0f, 0.05f, 0.3f, 0.8f};
+    const float updates[] = {0.0f, 1e-5f, 1e-3f};
+
+    dart::TrackerParameters p;
+    for(const int v : iters) { p = base; p.itersPerFrame = v; candidates.push_back(p); }
+    for(const int v : sizes) { p = base; p.obsSdfSize = v; candidates.push_back(p); }
+    for(const float v : scales) { p = base; p.modelSdfResolution = v*base.modelSdfResolution; candidates.push_back(p); }
+    for(const float v : scales) { p = base; p.modelSdfPadding = v*base.modelSdfPadding; candidates.push_back(p); }
+    for(const float v : thresholds) { p = base; p.distanceThreshold = v; candidates.push_back(p); }
+    for(const float v : rates) { p = base; p.infoAccumulationRate = v; candidates.push_back(p); }
+    for(const float v : updates) { p = base; p.minUpdateNorm = v; candidates.push_back(p); }
+    return candidates;
+}
+
+std::vector<dart::TrackerParameters> randomSearch(const dart::TrackerParameters &base, const int samples, const unsigned seed) {
+    // ranges of the sliders of track_manipulation
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> iters(1, 12);
+    std::uniform_int_distribution<int> size(2, 8);   // obsSdfSize in steps of 16
+    std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+    std::uniform_real_distribution<float> threshold(0.005f, 0.1f);
+    std::uniform_real_distribution<float> rate(0.0f, 1.0f);
+    std::uniform_real_distribution<float> log_update(-5.0f, -2.0f);
+
+    std::vector<dart::TrackerParameters> candidates;
+    for(int i=0; i<samples; i++) {
+        dart::TrackerParameters p;
+        p.itersPerFrame = iters(rng);
+        p.obsSdfSize = 16*size(rng);
+        p.modelSdfResolution = scale(rng)*base.modelSdfResolution;
+        p.modelSdfPadding = scale(rng)*base.modelSdfPadding;
+        p.distanceThreshold = threshold(rng);
+        p.infoAccumulationRate = rate(rng);
+        p.minUpdateNorm = std::pow(10.0f, log_update(rng));
+        p.minErrorChange = base.minErrorChange;
+        p.frameBudget = base.frameBudget;
+        candidates.push_back(p);
+    }
+    return candidates;
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string exe = "./track_manipulation";
+    std::string args;
+    std::string replay;
+    std::string base_file;
+    std::string out_file = "tracker_pareto.cfg";
+    int frames = 300;
+    int samples = 32;
+    bool use_sweep = false;
+    unsigned seed = 0;
+
+    for(int i=1; i<argc; i++) {
+        const bool has_value = i+1<argc;
+        if(std::strcmp(argv[i], "--exe")==0 && has_value)
+            exe = argv[++i];
+        else if(std::strcmp(argv[i], "--args")==0 && has_value)
+            args = argv[++i];
+        else if(std::strcmp(argv[i], "--replay")==0 && has_value)
+            replay = argv[++i];
+        else if(std::strcmp(argv[i], "--frames")==0 && has_value)
+            frames = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--base")==0 && has_value)
+            base_file = argv[++i];
+        else if(std::strcmp(argv[i], "--samples")==0 && has_value)
+            samples = std::atoi(argv[++i]);
+        else if(std::strcmp(argv[i], "--sweep")==0)
+            use_sweep = true;
+        else if(std::strcmp(argv[i], "--seed")==0 && has_value)
+            seed = std::strtoul(argv[++i], NULL, 10);
+        else if(std::strcmp(argv[i], "--out")==0 && has_value)
+            out_file = argv[++i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    dart::TrackerParameters base;
+    if(!base_file.empty()) {
+        std::vector<dart::TrackerConfig> configs;
+        if(!dart::loadTrackerConfigs(base_file, configs) || configs.empty())
+            return 1;
+        base = configs[dart::selectTrackerConfig(configs, 0)].params;
+    }
+
+    std::vector<dart::TrackerParameters> candidates(1, base);
+    const std::vector<dart::TrackerParameters> search = use_sweep ? sweep(base) : randomSearch(base, samples, seed);
+    candidates.insert(candidates.end(), search.begin(), search.end());
+
+    std::printf("%4s %6s %8s %10s %10s %10s %10s %10s %12s %12s %8s\n", "run", "iters", "obsSdf", "modelRes", "padding",
+                "distThr", "infoRate", "minUpdate", "p95 [ms]", "error [rad]", "iters/fr");
+
+    std::vector<dart::TrackerConfig> results;
+    for(size_t c=0; c<candidates.size(); c++) {
+        dart::TrackerConfig config;
+        config.params = candidates[c];
+        const dart::TrackerParameters &p = config.params;
+        std::printf("%4zu %6d %8d %10.4g %10.4g %10.4g %10.4g %10.4g ", c, p.itersPerFrame, p.obsSdfSize,
+                    p.modelSdfResolution, p.modelSdfPadding, p.distanceThreshold, p.infoAccumulationRate, p.minUpdateNorm);
+        std::fflush(stdout);
+
+        if(!evaluate(exe, args, replay, frames, config)) {
+            std::printf("%12s\n", "failed");
+            continue;
+        }
+        if(!config.measured()) {
+            std::printf("%12.3f %12s\n", config.latencyP95, "n/a");
+            continue;
+        }
+        std::printf("%12.3f %12.5f %8.2f\n", config.latencyP95, config.jointError, config.iterationsMean);
+        results.push_back(config);
+
+        // keep frontier up to date, so that an interrupted search still has a result
+        std::ostringstream comment;
+        comment << "Pareto frontier of track_manipulation parameters, p95 latency vs. joint error" << std::endl
+                << results.size() << " of " << candidates.size() << " configurations evaluated on " << frames << " frames" << std::endl
+                << "load with: track_manipulation --config FILE [--budget MS]";
+        dart::saveTrackerConfigs(out_file, dart::paretoFrontier(results), comment.str());
+    }
+
+    if(results.empty()) {
+        std::fprintf(stderr, "no configuration was evaluated successfully, joint error requires reported joints\n");
+        return 1;
+    }
+
+    const std::vector<dart::TrackerConfig> frontier = dart::paretoFrontier(results);
+    std::printf("\nPareto frontier (%zu configurations) written to %s\n", frontier.size(), out_file.c_str());
+    for(const dart::TrackerConfig &config : frontier)
+        std::printf("  p95 %8.3f ms  mean %8.3f ms  error %10.5f rad  iters %d  obsSdf %d\n",
+                    config.latencyP95, config.latencyMean, config.jointError,
+                    config.params.itersPerFrame, config.params.obsSdfSize);
+    return 0;
+}
@@ -0,0 +1,58 @@
+// Converts text tables of reported joint angles or contacts into the binary frame
+// table format, which track_manipulation maps into memory at startup.
+//
+//   convert_frame_table --joints ../video/reportedJointAngles.txt ../video/reportedJointAngles.dftb
+//   convert_frame_table --contacts ../video/reportedContacts.txt ../video/reportedContacts.dftb
+
+#include <frame_table.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+void usage(const char *name) {
+    std::fprintf(stderr,
+        "usage: %s (--joints|--contacts) INPUT.txt OUTPUT.dftb [--timestamps FILE]\n"
+        "  --joints         text table \"frames joints angles...\" of float values\n"
+        "  --contacts       text table \"frames contacts...\" of 10 int values per frame\n"
+        "  --timestamps     text file with one timestamp in microseconds per frame\n", name);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    std::string mode, input, output, timestamps;
+    for(int i=1; i<argc; i++) {
+        if(std::strcmp(argv[i], "--joints")==0 || std::strcmp(argv[i], "--contacts")==0)
+            mode = argv[i];
+        else if(std::strcmp(argv[i], "--timestamps")==0 && i+1<argc)
+            timestamps = argv[++i];
+        else if(input.empty())
+            input = argv[i];
+        else if(output.empty())
+            output = argv[i];
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if(mode.empty() || input.empty() || output.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    const bool joints = (mode=="--joints");
+    if(!dart::convertFrameTableText(input, output,
+                                    joints ? dart::FrameTableHeader::Float32 : dart::FrameTableHeader::Int32,
+                                    joints ? 0 : 10, timestamps))
+        return 1;
+
+    dart::MappedFrameTable table;
+    if(!table.open(output))
+        return 1;
+    std::printf("%s: %zu frames of %d %s\n", output.c_str(), table.frames(), table.columns(), joints ? "joint angles" : "contacts");
+    return 0;
+}
@@ -1,6 +1,14 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <iostream>
 #include <stdio.h>
 #include <string.h>
+#include <signal.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
 
 #include <GL/glew.h>
 #include <GL/freeglut.h>
@@ -10,8 +18,9 @@
 
 #include <Eigen/Dense>
 
-#include <cuda_runtime.h>
+#ifdef CUDA_BUILD
 #include <vector_types.h>
+#endif
 
 #include <dart/depth_sources/image_depth_source.h>
 #include <dart/geometry/plane_fitting.h>
@@ -29,6 +38,22 @@
 #include <dart/visualization/sdf_viz.h>
 
 #include <priors.hpp>
+#include <joint_index_map.hpp>
+#include <compute_backend.hpp>
+#include <double_buffer.hpp>
+#include <tracking_snapshot.hpp>
+#include <tracker_config.hpp>
+#include <iteration_policy.hpp>
+#include <stage_timer.hpp>
+#include <lcm_log_replay.hpp>
+#include <frame_table.hpp>
+#include <host_image_ops.hpp>
+#include <point_cloud_stream.hpp>
+#include <frame_arena.hpp>
+#include <point_batch.hpp>
+#include <collision_cloud_batch.hpp>
+#include <pose_slider_mirror.hpp>
+#include <parameter_handover.hpp>
 
 #define EIGEN_DONT_ALIGN
 
@@ -76,7 +101,7 @@
 #endif
 
 #ifdef ENABLE_LCM_JOINTS
-    #include <dart_lcm/dart_lcm_joints.hpp>
+    #include <lcm_joint_state.hpp>
 #endif
 
 #ifdef JUSTIN
@@ -136,6 +161,98 @@ static const int fullArmFingerTipFrames[10] = { 11, 15, 19, 23, 27,  38, 42, 46,
 static const int handFingerTipFrames[5] = { 4, 8, 12, 16, 20 };
 #endif
 
+/**
+ * Parameters of a tracking frame, sampled from the Pangolin variables by the UI thread.
+ * Requests are set for pushed buttons and for variables changed in the GUI that are only
+ * applied to the tracker when they change.
+ */
+struct FrameParameters {
+    struct Requests {
+        bool stepVideo;
+        bool stepVideoBack;
+        bool iterate;
+        bool resetRobotPose;
+        bool filteredNorms;
+        bool filteredVerts;
+        bool sigmaDepth;
+        bool sigmaPixels;
+        bool table;
+    } requests;
+
+    bool trackFromVideo;
+    bool sliderControlled;
+    bool useReportedPose;
+
+    // observed point cloud
+    bool filteredNorms;
+    bool filteredVerts;
+    float sigmaDepth;
+    float sigmaPixels;
+
+    // optimization options
+    float focalLength;
+    float normalThreshold;
+    float distanceThreshold;
+    float handRegularization;
+    float objectRegularization;
+    float lambdaModToObs;
+    float lambdaObsToMod;
+    float lambdaIntersection;
+    float lambdaContact;
+    float planeOffset;
+    int itersPerFrame;
+    float minUpdateNorm;
+    float minErrorChange;
+    float frameBudget;
+    float infoAccumulationRate;
+    float maxRotationDamping;
+    float maxTranslationDamping;
+    float resetInfoThreshold;
+    float stabilityThreshold;
+
+    // table plane as set in the GUI, and fitting it to the observed points
+    float3 tableNorm;
+    float tableIntercept;
+    bool fitTable;
+    bool subtractTable;
+    float planeFitNormThresh;
+    float planeFitDistThresh;
+    bool contacts[10];
+
+    // buffers captured for display
+    bool showTrackedPoints;
+    bool showPredictedPoints;
+    bool showObsSdf;
+    int pointColoringObs;
+    int pointColoringPred;
+    int debugImg;
+    float errMin;
+    float errMax;
+
+    FrameParameters() {
+        memset(this,0,sizeof(FrameParameters));
+    }
+
+    // take the values of newer parameters, requests are kept until they are handled
+    void merge(const FrameParameters & newer) {
+        const Requests pending = requests;
+        *this = newer;
+        requests.stepVideo |= pending.stepVideo;
+        requests.stepVideoBack |= pending.stepVideoBack;
+        requests.iterate |= pending.iterate;
+        requests.resetRobotPose |= pending.resetRobotPose;
+        requests.filteredNorms |= pending.filteredNorms;
+        requests.filteredVerts |= pending.filteredVerts;
+        requests.sigmaDepth |= pending.sigmaDepth;
+        requests.sigmaPixels |= pending.sigmaPixels;
+        requests.table |= pending.table;
+    }
+
+    void clearRequests() {
+        memset(&requests,0,sizeof(Requests));
+    }
+};
+
 const static int panelWidth = 180;
 
 void setSlidersFromTransform(dart::SE3& transform, pangolin::Var<float>** sliders) {
@@ -164,49 +281,25 @@ const static int leftShoulderFrame = 28;
 const static int leftPalmFrame = 34;
 const static int headFrame = 56;
 
-void loadReportedJointAngles(std::string jointAngleFile, std::vector<float *> & jointAngles) {
-    int nFrames;
-    int nJoints;
-
-    std::ifstream jointAngleStream;
-    jointAngleStream.open(jointAngleFile);
-
-    assert(jointAngleStream.is_open());
-
-    jointAngleStream >> nFrames;
-
-    jointAngleStream >> nJoints;
-
-    for (int i=0; i<nFrames; ++i) {
-
-        float * frameAngles = new float[nJoints];
-        for (int j=0; j<nJoints; ++j) {
-            jointAngleStream >> frameAngles[j];
-        }
-        jointAngles.push_back(frameAngles);
+/**
+ * @brief openReportedTable map binary frame table of reported values of a sequence
+ * The binary table (e.g. reportedJointAngles.dftb) is created from the text table
+ * (reportedJointAngles.txt) if it does not exist yet, see tools/convert_frame_table.
+ * @param columns values per frame, read from the text table if 0
+ * @return false if neither table could be loaded
+ */
+bool openReportedTable(const std::string & basename, const dart::FrameTableHeader::ValueType type, const int columns, dart::MappedFrameTable & table) {
+    const std::string binaryFile = basename + ".dftb";
+    if (table.open(binaryFile)) {
+        return true;
     }
 
-    jointAngleStream.close();
-}
-
-void loadReportedContacts(std::string contactFile, std::vector<int *> & contacts) {
-    int nFrames, nContactFrames;
-    int nJoints;
-
-    std::ifstream contactStream;
-    contactStream.open(contactFile);
-
-    contactStream >> nContactFrames;
-
-    for (int i=0; i<nContactFrames; ++i) {
-        int * frameContacts = new int[10];
-        for (int j=0; j<10; ++j) {
-            contactStream >> frameContacts[j];
-        }
-        contacts.push_back(frameContacts);
+    std::cout << "converting " << basename << ".txt to " << binaryFile << std::endl;
+    if (!dart::convertFrameTableText(basename + ".txt", binaryFile, type, columns) || !table.open(binaryFile)) {
+        std::cerr << "could not load reported values " << basename << std::endl;
+        return false;
     }
-
-    contactStream.close();
+    return true;
 }
 #endif
 
@@ -244,6 +337,13 @@ static const dart::SE3 initialT_co(make_float4(0.262348, -0.955909, -0.131952, 0
 static float3 initialTableNorm = make_float3(0.0182391, 0.665761, -0.745942);
 static float initialTableIntercept = -0.705196;
 
+// set by SIGINT/SIGTERM to leave the main loop, e.g. in headless mode without window
+static volatile sig_atomic_t quitRequested = 0;
+
+void requestQuit(int) {
+    quitRequested = 1;
+}
+
 int main(int argc, char *argv[]) {
 
 #ifdef ENABLE_JUSTIN
@@ -254,14 +354,88 @@ int main(int argc, char *argv[]) {
     const std::string videoLoc = "../video/";
 #endif
 
+    // -=-=-=- command line -=-=-=-
+    // --headless: no window and no rendering, track as fast as input arrives
+    // --frames N: stop after N input frames
+    // --config FILE: load tracker parameters, e.g. the Pareto frontier written by autotune_tracker
+    // --budget MS: select the most accurate configuration of FILE within a p95 latency budget per frame
+    // --report FILE: write parameters with measured latency and joint error at exit
+    // --stats-socket PATH: serve per-stage timing statistics on a Unix socket
+    // --stats-interval S: dump per-stage timing statistics to stdout every S seconds
+    // --replay LOG: replay images and robot states of an lcmlog frame by frame instead of listening to LCM
+    // --replay-speed X: replay at X times the recorded rate, as fast as possible if 0 (default)
+    // --frame-report FILE: write latency, iterations and errors of every frame as CSV
+    // --input-timeout S: end a headless run if no new depth image arrives within S seconds, 0 waits forever (default 5)
+    bool headless = false;
+    int maxFrames = 0;
+    std::string configFile;
+    float latencyBudget = 0;
+    std::string reportFile;
+    std::string statsSocket;
+    double statsInterval = 0;
+    std::string replayLog;
+    double replaySpeed = 0;
+    std::string frameReportFile;
+    double inputTimeout = 5;
+    for (int i=1; i<argc; ++i) {
+        if (strcmp(argv[i],"--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i],"--frames") == 0 && i+1<argc) {
+            maxFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i],"--config") == 0 && i+1<argc) {
+            configFile = argv[++i];
+        } else if (strcmp(argv[i],"--budget") == 0 && i+1<argc) {
+            latencyBudget = atof(argv[++i]);
+        } else if (strcmp(argv[i],"--report") == 0 && i+1<argc) {
+            reportFile = argv[++i];
+        } else if (strcmp(argv[i],"--stats-socket") == 0 && i+1<argc) {
+            statsSocket = argv[++i];
+        } else if (strcmp(argv[i],"--stats-interval") == 0 && i+1<argc) {
+            statsInterval = atof(argv[++i]);
+        } else if (strcmp(argv[i],"--replay") == 0 && i+1<argc) {
+            replayLog = argv[++i];
+        } else if (strcmp(argv[i],"--replay-speed") == 0 && i+1<argc) {
+            replaySpeed = atof(argv[++i]);
+        } else if (strcmp(argv[i],"--frame-report") == 0 && i+1<argc) {
+            frameReportFile = argv[++i];
+        } else if (strcmp(argv[i],"--input-timeout") == 0 && i+1<argc) {
+            inputTimeout = atof(argv[++i]);
+        }
+    }
+
+    dart::TrackerParameters params;
+    if (!configFile.empty()) {
+        std::vector<dart::TrackerConfig> configs;
+        if (!dart::loadTrackerConfigs(configFile,configs) || configs.empty()) {
+            std::cerr << "no tracker configuration in " << configFile << std::endl;
+            return 1;
+        }
+        const int c = dart::selectTrackerConfig(configs,latencyBudget);
+        params = configs[c].params;
+        std::cout << "using configuration " << c << " of " << configFile;
+        if (configs[c].measured()) {
+            std::cout << " (p95 latency " << configs[c].latencyP95 << " ms, joint error " << configs[c].jointError << " rad)";
+        }
+        std::cout << std::endl;
+    }
+
+    signal(SIGINT, requestQuit);
+    signal(SIGTERM, requestQuit);
+
     // -=-=-=- initializations -=-=-=-
-    cudaSetDevice(0);
-    cudaDeviceReset();
+    dart::backend::initialise(0);
 
-    pangolin::CreateWindowAndBind("Main",640+4*panelWidth+1,2*480+1);
+    if (headless) {
+        // offscreen GL context for the model meshes, no window system required
+        pangolin::CreateWindowAndBind("Main",640,480,pangolin::Params({{"scheme", "headless"}}));
+    } else {
+        pangolin::CreateWindowAndBind("Main",640+4*panelWidth+1,2*480+1);
+    }
 
     glewInit();
-    glutInit(&argc, argv);
+    if (!headless) {
+        glutInit(&argc, argv);
+    }
     dart::Tracker tracker;
 
     // -=-=-=- pangolin window setup -=-=-=-
@@ -347,6 +521,22 @@ int main(int argc, char *argv[]) {
 #endif
 
 #ifdef DEPTH_SOURCE_LCM
+    // Replay: the tracking loop pulls one image per frame from the log and republishes it
+    // on a host-local bus (ttl=0), on which all LCM subscribers listen. The bus uses a free
+    // port of its own, so that concurrent replays and live systems on the same host are not disturbed.
+    std::unique_ptr<dart::LCM_LogReplay> replay;
+    if (!replayLog.empty()) {
+        const std::string replayBus = dart::LCM_LogReplay::localBus();
+        if (replayBus.empty()) {
+            return 1;
+        }
+        LCM_CommonBase::setProvider(replayBus);
+        replay.reset(new dart::LCM_LogReplay(replayLog,replayBus,replaySpeed));
+        if (!replay->good()) {
+            return 1;
+        }
+    }
+
     // example of using log file
     // exit after failure, used to stop publishing when end of logfile is reached
 //    LCM_CommonBase::exitOnFailure(true);
@@ -370,6 +560,7 @@ int main(int argc, char *argv[]) {
     // initialise LCM depth source and listen on channel "CAMERA" in a separate thread
     dart::LCM_DepthSource<float,uchar3> *depthSource = new dart::LCM_DepthSource<float,uchar3>(val_multisense);
     depthSource->subscribe_images("CAMERA");
+    if (replay) { replay->setFrameChannel("CAMERA"); }
     //depthSource->subscribe_images("CAMERA_FILTERED");
     depthSource->setMaxDepthDistance(1.0); // meter
 
@@ -389,6 +580,7 @@ int main(int argc, char *argv[]) {
     // initialise LCM depth source and listen on channel "CAMERA" in a separate thread
     dart::LCM_DepthSource<float,uchar3> *depthSource = new dart::LCM_DepthSource<float,uchar3>(val_xtion);
     depthSource->subscribe_images("OPENNI_FRAME");
+    if (replay) { replay->setFrameChannel("OPENNI_FRAME"); }
 
     const std::string cam_frame_name = "head_xtion_joint";
 #endif
@@ -396,18 +588,23 @@ int main(int argc, char *argv[]) {
     tracker.addDepthSource(depthSource);
     dart::Optimizer & optimizer = *tracker.getOptimizer();
 
-    const static int obsSdfSize = 64;
-    const static float obsSdfResolution = 0.01*32/obsSdfSize;
+    // extent of the observation SDF is fixed, its size trades resolution for speed
+    const int obsSdfSize = params.obsSdfSize;
+    const float obsSdfResolution = 0.01*32/obsSdfSize;
     const static float defaultModelSdfResolution = 2e-3; //1.5e-3;
     const static float3 obsSdfOffset = make_float3(0,0,0.1);
 
-    pangolin::Var<float> modelSdfResolution("lim.modelSdfResolution",defaultModelSdfResolution,defaultModelSdfResolution/2,defaultModelSdfResolution*2);
-    pangolin::Var<float> modelSdfPadding("lim.modelSdfPadding",defaultModelSdfPadding,defaultModelSdfPadding/2,defaultModelSdfPadding*2);
+    pangolin::Var<float> modelSdfResolution("lim.modelSdfResolution",params.modelSdfResolution,defaultModelSdfResolution/2,defaultModelSdfResolution*2);
+    pangolin::Var<float> modelSdfPadding("lim.modelSdfPadding",params.modelSdfPadding,defaultModelSdfPadding/2,defaultModelSdfPadding*2);
 
 #ifdef ENABLE_JUSTIN
     dart::ParamMapPoseReduction * handPoseReduction = dart::loadParamMapPoseReduction("../models/spaceJustin/justinHandParamMap.txt");
 
-    tracker.addModel("../models/spaceJustin/spaceJustinHandRight.xml",
+    // host models of the tracked models are kept for rendering
+    dart::HostOnlyModel rightHandModel;
+    dart::readModelXML("../models/spaceJustin/spaceJustinHandRight.xml",rightHandModel);
+    rightHandModel.computeStructure();
+    tracker.addModel(rightHandModel,
                      modelSdfResolution,
                      modelSdfPadding,
                      obsSdfSize,
@@ -429,14 +626,20 @@ int main(int argc, char *argv[]) {
     dart::Pose spaceJustinPose(justinPoseReduction);
 //    std::cout << spaceJustinPose.getReducedArticulatedDimensions() << " full justin articulated dimensions" << std::endl;
 
-    tracker.addModel(objectModelFile,
+    dart::HostOnlyModel objectModel;
+    dart::readModelXML(objectModelFile.c_str(),objectModel);
+    objectModel.computeStructure();
+    tracker.addModel(objectModel,
                      0.5*modelSdfResolution,
                      modelSdfPadding,
                      64);
 //                     objObsSdfRes,
 //                     objObsSdfOffset);
 
-    tracker.addModel("../models/spaceJustin/spaceJustinHandLeft.xml",
+    dart::HostOnlyModel leftHandModel;
+    dart::readModelXML("../models/spaceJustin/spaceJustinHandLeft.xml",leftHandModel);
+    leftHandModel.computeStructure();
+    tracker.addModel(leftHandModel,
                      //"../models/spaceJustinArms.xml",
                      //0.1,
                      modelSdfResolution,
@@ -550,25 +753,33 @@ int main(int argc, char *argv[]) {
 
     // individually weighted joints
 //    const unsigned int val_torso_dims = tracker.getPose(tracker.getModelIDbyName("valkyrie")).getReducedArticulatedDimensions();
-//    // TODO: replace Q by sparse matrix
-//    Eigen::MatrixXf Q = 1 * Eigen::MatrixXf::Identity(val_torso_dims, val_torso_dims);
+//    Eigen::SparseMatrix<float> Q(val_torso_dims, val_torso_dims);
+//    Q.setIdentity();
 
 //    // change weights for left fingers in index 11..23
 //    for(unsigned int i=11; i<=23; i++) {
-//        Q(i,i) = 0.2;
-//        //Q(i,i) = 2.0;
+//        Q.coeffRef(i,i) = 0.2;
+//        //Q.coeffRef(i,i) = 2.0;
 //    }
 //    // change weights for left wrist roll/pitch in index 6,7
 //    for(unsigned int i=6; i<=7; i++) {
-//        Q(i,i) = 1;
-//        //Q(i,i) = 5;
-//        //Q(i,i) = 25;
+//        Q.coeffRef(i,i) = 1;
+//        //Q.coeffRef(i,i) = 5;
+//        //Q.coeffRef(i,i) = 25;
 //    }
 
 //    dart::QWeightedError val_rep(tracker.getModelIDbyName("valkyrie"), val_pose, tracker.getPose("valkyrie"), Q);
 
+    // robust per-joint weighting, joints deviating more than ~0.1 rad are down-weighted
+//    dart::HuberWeightedError val_rep(tracker.getModelIDbyName("valkyrie"), val_pose, tracker.getPose("valkyrie"), Q, 0.1);
+
 //    tracker.addPrior(&val_rep);
 
+    // publish prior gradient on "DART_GRADIENT" for debugging, at most 10 Hz without fixed joints
+//    dart::LCMGradientSink val_rep_gradient_sink("DART_GRADIENT");
+//    dart::GradientTelemetry val_rep_gradient(&val_rep_gradient_sink, tracker.getPose("valkyrie"), 10, true);
+//    val_rep.setTelemetry(&val_rep_gradient);
+
     // prevent movement of the camera frame by enforcing no transformation
     dart::NoCameraMovementPrior val_cam(tracker.getModelIDbyName("valkyrie"));
     tracker.addPrior(&val_cam);
@@ -599,6 +810,12 @@ int main(int argc, char *argv[]) {
 
     }
 
+    // changed poses are pushed to the sliders and moved sliders to the poses in batches
+    dart::PoseSliderMirror poseSliders;
+    for (int m=0; m<tracker.getNumModels(); ++m) {
+        poseSliders.addModel(poseVars[m],tracker.getPose(m).getReducedDimensions());
+    }
+
     // pangolin variables
 //    static pangolin::Var<bool> trackFromVideo("ui.track",false,false,true);
     static pangolin::Var<bool> trackFromVideo("ui.track",true,false,true);
@@ -611,6 +828,8 @@ int main(int argc, char *argv[]) {
 
     static pangolin::Var<float> sigmaPixels("ui.sigmaPixels",3.0,0.01,4);
     static pangolin::Var<float> sigmaDepth("ui.sigmaDepth",0.1,0.001,1);
+    static pangolin::Var<bool> filteredNorms("ui.filteredNorms",false,true);
+    static pangolin::Var<bool> filteredVerts("ui.filteredVerts",false,true);
     static pangolin::Var<float> focalLength("ui.focalLength",depthSource->getFocalLength().x,0.8*depthSource->getFocalLength().x,1.2*depthSource->getFocalLength().x);//475,525); //525.0,450.0,600.0);
     //static pangolin::Var<float> focalLength_y("ui.focalLength_y",depthSource->getFocalLength().y, 500, 1500);
     static pangolin::Var<bool> showCameraPose("ui.showCameraPose",false,true);
@@ -633,6 +852,8 @@ int main(int argc, char *argv[]) {
 #endif
     static pangolin::Var<int> pointColoringObs("ui.pointColoringObs",0,0,NumPointColorings-1);
     static pangolin::Var<int> pointColoringPred("ui.pointColoringPred",0,0,NumPointColorings-1);
+    static pangolin::Var<float> errMin("ui.errMin",0,0,0.05);
+    static pangolin::Var<float> errMax("ui.errMax",0.01,0,0.05);
 #ifdef JUSTIN
     static pangolin::Var<float> planeOffset("ui.planeOffset",-0.03,-0.05,0);
 #endif
@@ -645,12 +866,21 @@ int main(int argc, char *argv[]) {
 
     static pangolin::Var<bool> record("ui.Record Start/Stop",false,false);
     static pangolin::Var<float> fps("ui.fps",0);
+    static pangolin::Var<int> itersUsed("ui.itersUsed",0);
+    static pangolin::Var<std::string> stopReason("ui.stopReason");
+#ifdef ENABLE_JUSTIN
+    static pangolin::Var<std::string> trackingModeStr("ui.mode");
+#endif
 
     // optimization options
     pangolin::Var<bool> iterateButton("opt.iterate",false,false);
-    pangolin::Var<int> itersPerFrame("opt.itersPerFrame",3,0,30);
+    pangolin::Var<int> itersPerFrame("opt.itersPerFrame",params.itersPerFrame,0,30);
+    // stop iterating when the pose converged or the frame budget (ms) is used up, 0 disables
+    pangolin::Var<float> minUpdateNorm("opt.minUpdateNorm",params.minUpdateNorm,0,1e-2);
+    pangolin::Var<float> minErrorChange("opt.minErrorChange",params.minErrorChange,0,0.1);
+    pangolin::Var<float> frameBudget("opt.frameBudget",params.frameBudget,0,100);
     pangolin::Var<float> normalThreshold("opt.normalThreshold",-1.01,-1.01,1.0);
-    pangolin::Var<float> distanceThreshold("opt.distanceThreshold",0.035,0.0,0.1);
+    pangolin::Var<float> distanceThreshold("opt.distanceThreshold",params.distanceThreshold,0.0,0.1);
     pangolin::Var<float> handRegularization("opt.handRegularization",0.1,0,10); // 1.0
     pangolin::Var<float> objectRegularization("opt.objectRegularization",0.1,0,10); // 1.0
     pangolin::Var<float> resetInfoThreshold("opt.resetInfoThreshold",1.0e-5,1e-5,2e-5);
@@ -664,7 +894,7 @@ int main(int argc, char *argv[]) {
 #endif
 
 
-    pangolin::Var<float> infoAccumulationRate("opt.infoAccumulationRate",0.1,0.0,1.0); // 0.8
+    pangolin::Var<float> infoAccumulationRate("opt.infoAccumulationRate",params.infoAccumulationRate,0.0,1.0); // 0.8
     pangolin::Var<float> maxRotationDamping("opt.maxRotationalDamping",50,0,200);
     pangolin::Var<float> maxTranslationDamping("opt.maxTranslationDamping",5,0,10);
 
@@ -675,6 +905,8 @@ int main(int argc, char *argv[]) {
     pangolin::Var<float> tableIntercept("opt.tableIntercept",initialTableIntercept,-1,1);
     static pangolin::Var<bool> fitTable("opt.fitTable",true,true);
     static pangolin::Var<bool> subtractTable("opt.subtractTable",true,true);
+    static pangolin::Var<float> planeFitNormThresh("opt.planeNormThresh",0.25,-1,1);
+    static pangolin::Var<float> planeFitDistThresh("opt.planeDistThresh",0.005,0.0001,0.005);
 #endif
 
 #ifdef USE_CONTACT_PRIOR
@@ -692,6 +924,79 @@ int main(int argc, char *argv[]) {
     bool anyContact = false;
 #endif
 
+    // Pangolin variables are only accessed by the UI thread. It samples them once per
+    // rendered frame and hands them over to the tracking thread.
+    auto sampleFrameParameters = [&](FrameParameters & p) {
+        p.requests.stepVideo = pangolin::Pushed(stepVideo);
+        p.requests.stepVideoBack = pangolin::Pushed(stepVideoBack);
+        p.requests.iterate = pangolin::Pushed(iterateButton);
+        p.requests.filteredNorms = filteredNorms.GuiChanged();
+        p.requests.filteredVerts = filteredVerts.GuiChanged();
+        p.requests.sigmaDepth = sigmaDepth.GuiChanged();
+        p.requests.sigmaPixels = sigmaPixels.GuiChanged();
+
+        p.trackFromVideo = trackFromVideo;
+        p.sliderControlled = sliderControlled;
+#ifdef ENABLE_URDF
+        p.requests.resetRobotPose = pangolin::Pushed(resetRobotPose);
+        p.useReportedPose = useReportedPose;
+#endif
+
+        p.filteredNorms = filteredNorms;
+        p.filteredVerts = filteredVerts;
+        p.sigmaDepth = sigmaDepth;
+        p.sigmaPixels = sigmaPixels;
+
+        p.focalLength = focalLength;
+        p.normalThreshold = normalThreshold;
+        p.distanceThreshold = distanceThreshold;
+        p.handRegularization = handRegularization;
+        p.objectRegularization = objectRegularization;
+        p.lambdaModToObs = lambdaModToObs;
+        p.lambdaObsToMod = lambdaObsToMod;
+        p.itersPerFrame = itersPerFrame;
+        p.minUpdateNorm = minUpdateNorm;
+        p.minErrorChange = minErrorChange;
+        p.frameBudget = frameBudget;
+        p.infoAccumulationRate = infoAccumulationRate;
+        p.maxRotationDamping = maxRotationDamping;
+        p.maxTranslationDamping = maxTranslationDamping;
+        p.resetInfoThreshold = resetInfoThreshold;
+        p.stabilityThreshold = stabilityThreshold;
+#ifdef USE_CONTACT_PRIOR
+        p.lambdaIntersection = lambdaIntersection;
+        p.lambdaContact = lambdaContact;
+        for (int i=0; i<10; ++i) {
+            p.contacts[i] = *contactVars[i];
+        }
+#endif
+#ifdef JUSTIN
+        p.planeOffset = planeOffset;
+        // evaluate all variables to reset their changed flags
+        p.requests.table = tableNormX.GuiChanged() | tableNormY.GuiChanged() | tableNormZ.GuiChanged() | tableIntercept.GuiChanged();
+        p.tableNorm = make_float3(tableNormX,tableNormY,tableNormZ);
+        p.tableIntercept = tableIntercept;
+        p.fitTable = fitTable;
+        p.subtractTable = subtractTable;
+        p.planeFitNormThresh = planeFitNormThresh;
+        p.planeFitDistThresh = planeFitDistThresh;
+#endif
+
+        if (showPointColour) {
+            pointColoringObs = PointColoringRGB;
+        } else if (pointColoringObs == PointColoringRGB) {
+            pointColoringObs = PointColoringNone;
+        }
+        p.showTrackedPoints = showTrackedPoints;
+        p.showPredictedPoints = showPredictedPoints;
+        p.showObsSdf = showObsSdf;
+        p.pointColoringObs = pointColoringObs;
+        p.pointColoringPred = pointColoringPred;
+        p.debugImg = debugImg;
+        p.errMin = errMin;
+        p.errMax = errMax;
+    };
+
     int fpsWindow = 10;
     pangolin::basetime lastTime = pangolin::TimeNow();
 
@@ -709,18 +1014,32 @@ int main(int argc, char *argv[]) {
     }
     allSdfColors.syncHostToDevice();
 
-    // set up VBO to display point cloud
-    GLuint pointCloudVbo,pointCloudColorVbo,pointCloudNormVbo;
-    glGenBuffersARB(1,&pointCloudVbo);
-    glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudVbo);
-    glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(float4),tracker.getHostVertMap(),GL_DYNAMIC_DRAW_ARB);
-    glGenBuffersARB(1,&pointCloudColorVbo);
-    glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudColorVbo);
-    glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(uchar3),imgDepthSize.hostPtr(),GL_DYNAMIC_DRAW_ARB);
-    glGenBuffersARB(1,&pointCloudNormVbo);
-    glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudNormVbo);
-    glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(float4),tracker.getHostNormMap(),GL_DYNAMIC_DRAW_ARB);
+    // scratch memory of the debug visualisation of a tracking frame, i.e. the predicted
+    // depth copied to the host and the squared error image on the device
+    dart::FrameArena frameArena(predWidth*predHeight*sizeof(float4),depthWidth*depthHeight*sizeof(float));
+
+    // stream to display point cloud, uploads only the buffers of the point coloring
+    std::unique_ptr<dart::PointCloudStream> pointCloudStream;
+    // batch of predicted points, colored by SDF or by error
+    std::unique_ptr<dart::PointBatch> predictedPointBatch;
+    // collision clouds of all models in the camera frame
+    std::unique_ptr<dart::CollisionCloudBatch> collisionCloudBatch;
+    std::vector<std::vector<dart::SE3> > collisionFrameToCamera(tracker.getNumModels());
+    if (!headless) {
+        pointCloudStream.reset(new dart::PointCloudStream(depthWidth*depthHeight));
+        predictedPointBatch.reset(new dart::PointBatch(predWidth*predHeight));
+        collisionCloudBatch.reset(new dart::CollisionCloudBatch());
+    }
 
+    // colors of the predicted points by the (model, sdf) label
+    dart::SdfColorTable sdfColorTable;
+    for (int m=0; m<tracker.getNumModels(); ++m) {
+        std::vector<uchar3> sdfColors(tracker.getModel(m).getNumSdfs());
+        for (int s=0; s<tracker.getModel(m).getNumSdfs(); ++s) {
+            sdfColors[s] = tracker.getModel(m).getSdfColor(s);
+        }
+        sdfColorTable.addModel(sdfColors);
+    }
 
     dart::OptimizationOptions & opts = tracker.getOptions();
     opts.lambdaObsToMod = 1;
@@ -794,13 +1113,19 @@ int main(int argc, char *argv[]) {
 
 #ifdef ENABLE_JUSTIN
     // set up reported pose offsets
-    std::vector<float *> reportedJointAngles;
-    loadReportedJointAngles(videoLoc+"/reportedJointAngles.txt", reportedJointAngles);
+    dart::MappedFrameTable reportedJointAngleTable;
+    if (!openReportedTable(videoLoc+"/reportedJointAngles", dart::FrameTableHeader::Float32, 0, reportedJointAngleTable)) {
+        return 1;
+    }
+    const dart::StridedView<float> reportedJointAngles = reportedJointAngleTable.floats();
 #endif
 
 #ifdef USE_CONTACT_PRIOR
-    std::vector<int *> reportedContacts;
-    loadReportedContacts(videoLoc+"/reportedContacts.txt", reportedContacts);
+    dart::MappedFrameTable reportedContactTable;
+    if (!openReportedTable(videoLoc+"/reportedContacts", dart::FrameTableHeader::Int32, 10, reportedContactTable)) {
+        return 1;
+    }
+    const dart::StridedView<int> reportedContacts = reportedContactTable.ints();
 #endif
 
 #ifdef ENABLE_JUSTIN
@@ -809,14 +1134,25 @@ int main(int argc, char *argv[]) {
 
 #ifdef ENABLE_LCM_JOINTS
     // measures joint values for reported robot configuration
-    dart::LCM_JointsProvider lcm_joints;
-    lcm_joints.setJointNames(val);
-    // listen on channel "EST_ROBOT_STATE" in a separate thread
-    lcm_joints.subscribe_robot_state(LCM_CHANNEL_ROBOT_STATE);
+    // listen on channel "EST_ROBOT_STATE" in a separate thread, joint values are in order of val_pose
+#ifdef DEPTH_SOURCE_LCM
+    // during replay, states of the log are written in order with the images and the subscriber does not listen
+    dart::LCM_JointStateSubscriber lcm_joints(val_pose, LCM_CHANNEL_ROBOT_STATE, replay ? "memq://" : "");
+    if (replay) {
+        replay->subscribe<bot_core::robot_state_t>(LCM_CHANNEL_ROBOT_STATE, [&](const bot_core::robot_state_t &msg) {
+            lcm_joints.write(msg);
+        });
+    }
+#else
+    dart::LCM_JointStateSubscriber lcm_joints(val_pose, LCM_CHANNEL_ROBOT_STATE);
+#endif
 
     dart::LCM_StatePublish lcm_robot_state(LCM_CHANNEL_ROBOT_STATE, LCM_CHANNEL_DART_PREFIX, val_torso_pose);
     dart::LCM_FramePosePublish lcm_frame_pub("DART", val, val_torso_mm);
 
+    // mapping of reported Valkyrie joints to joints of tracked subpart
+    dart::JointIndexMap val_torso_joint_map;
+
 #ifdef WITH_BOTTLE
     dart::MirroredModel & bottle_mm = tracker.getModel(tracker.getModelIDbyName("bottle"));
     dart::LCM_FramePosePublish lcm_object_frame_pub("DART", bottle, bottle_mm);
@@ -843,7 +1179,9 @@ int main(int argc, char *argv[]) {
     // wait to get initial configuration of robot from LCM thread
     usleep(100000);
     // set initial state of tracked model
-    val_torso_pose.setReducedArticulation(lcm_joints.getJointsNameValue());
+    lcm_joints.snapshot(val_pose);
+    val_torso_joint_map.update(val_pose, val_torso_pose);
+    val_torso_joint_map.gather(val_pose.getReducedArticulation(), val_torso_pose.getReducedArticulation());
     val_torso_mm.setPose(val_torso_pose);
     dart::SE3 Tmc = val_torso_mm.getTransformModelToFrame(val_torso_cam_frame_id);
     val_torso_pose.setTransformModelToCamera(Tmc);
@@ -875,31 +1213,150 @@ int main(int argc, char *argv[]) {
     TrackingMode trackingMode = ModeObjOnTable;
 #endif
 
-    // ------------------- main loop ---------------------
-    for (int pangolinFrame=1; !pangolin::ShouldQuit(); ++pangolinFrame) {
+    if (headless) {
+        trackFromVideo = true;
+        sliderControlled = false;
+    }
 
-        if (pangolin::HasResized()) {
-            pangolin::DisplayBase().ActivateScissorAndClear();
+    // throughput of headless mode
+    const pangolin::basetime headlessStart = pangolin::TimeNow();
+    pangolin::basetime headlessFrameStart = headlessStart;
+    double headlessMaxFrameTime = 0;
+    int headlessFrames = 0;
+
+    // tracking latency per frame in ms and deviation from reported joints, for --report
+    std::vector<float> frameLatencies;
+    frameLatencies.reserve(std::max(maxFrames,0));
+    double jointErrorSum = 0;
+    int jointErrorFrames = 0;
+#ifdef ENABLE_LCM_JOINTS
+    std::vector<float> reportedTorsoJoints(val_torso_pose.getReducedArticulatedDimensions());
+#endif
+
+    // optimization of each frame, iterations and reasons for stopping
+    dart::IterationPolicy iterationPolicy;
+    std::vector<float> policyParams;
+    long iterationSum = 0;
+    int iterationFrames = 0;
+    std::vector<int> stopReasonCounts(dart::IterationPolicy::NumStopReasons,0);
+
+    // translation, rotation (se3) and articulation of all models
+    auto gatherPoseParameters = [&](std::vector<float> & params) {
+        params.clear();
+        for (int m=0; m<tracker.getNumModels(); ++m) {
+            dart::Pose & pose = tracker.getPose(m);
+            const dart::SE3 T_cm = pose.getTransformModelToCamera();
+            const dart::se3 t_cm = dart::se3FromSE3(T_cm);
+            params.push_back(T_cm.r0.w);
+            params.push_back(T_cm.r1.w);
+            params.push_back(T_cm.r2.w);
+            params.push_back(t_cm.p[3]);
+            params.push_back(t_cm.p[4]);
+            params.push_back(t_cm.p[5]);
+            params.insert(params.end(),pose.getReducedArticulation(),pose.getReducedArticulation()+pose.getReducedArticulatedDimensions());
+        }
+    };
+
+    // error per observed and per predicted point, summed over all models
+    auto sumPointErrors = [&](float & errObsToMod, float & errModToObs) {
+        errObsToMod = errModToObs = 0;
+        for (int m=0; m<tracker.getNumModels(); ++m) {
+            errObsToMod += optimizer.getErrPerObsPoint(m,0);
+            errModToObs += optimizer.getErrPerModPoint(m,0);
         }
+    };
+
+    // results of the last tracked frame for --frame-report
+    struct FrameResult {
+        int iterations;
+        dart::IterationPolicy::StopReason stopReason;
+        float errObsToMod;
+        float errModToObs;
+        float jointError;
+    } frameResult;
+
+    std::ofstream frameReport;
+    if (!frameReportFile.empty()) {
+        frameReport.open(frameReportFile.c_str());
+        if (!frameReport) {
+            std::cerr << "cannot write frame report " << frameReportFile << std::endl;
+            return 1;
+        }
+        frameReport << "frame,log_utime,latency_ms,iterations,stop_reason,err_obs_to_mod,err_mod_to_obs,joint_error,host_scratch,device_scratch" << std::endl;
+    }
+
+    // time spent per frame in the stages of tracking and rendering
+    dart::StageTimers stageTimers;
+    const int stageFrame = stageTimers.addStage("frame");
+    const int stageStep = stageTimers.addStage("stepForward");
+    const int stageOptimize = stageTimers.addStage("optimizePoses");
+    const int stageDamping = stageTimers.addStage("damping");
+    const int stagePublish = stageTimers.addStage("publish");
+    const int stageSnapshot = stageTimers.addStage("snapshot");
+    const int stageRender = stageTimers.addStage("render");
+    std::unique_ptr<dart::StatsServer> statsServer;
+    if (!statsSocket.empty() || statsInterval > 0) {
+        statsServer.reset(new dart::StatsServer(stageTimers,statsSocket,statsInterval));
+    }
+
+    // ------------------- tracking ---------------------
+    // The tracking loop runs on its own thread and publishes the results of each frame
+    // in a snapshot. The main thread renders the latest snapshot at display rate, so the
+    // visualization does not delay tracking. The main thread does not access the tracker,
+    // it renders the models in the poses of the snapshot. The tracking thread does not
+    // access Pangolin variables, the main thread samples them for each frame.
+    dart::DoubleBuffer<dart::TrackingSnapshot> snapshots;
+    std::atomic<bool> stopTracking(false);
+
+    // parameters of the current frame, sampled by the UI thread, and the state the tracking
+    // thread reports back to the UI in the snapshot
+    dart::ParameterHandover<FrameParameters> frameParameterHandover;
+    FrameParameters frameParams;
+    sampleFrameParameters(frameParams);
+    float trackingFps = 0;
+#ifdef ENABLE_JUSTIN
+    float3 trackedTableNorm = initialTableNorm;
+    float trackedTableIntercept = initialTableIntercept;
+#endif
+#ifdef USE_CONTACT_PRIOR
+    bool contactState[10] = { false };
+#endif
+
+    auto trackFrame = [&](const int trackingFrame) {
+
+        dart::ScopedStageTimer frameTimer(stageTimers,stageFrame);
+        dart::TrackingSnapshot & snapshot = snapshots.back();
+        snapshot.optimized = false;
+        snapshot.iterations = 0;
+        snapshot.stopReason = dart::IterationPolicy::NotOptimized;
+        frameResult.iterations = 0;
+        frameResult.stopReason = dart::IterationPolicy::NotOptimized;
+        frameResult.errObsToMod = frameResult.errModToObs = frameResult.jointError = -1;
 
 #ifdef ENABLE_URDF
-        tracker.stepForward();
+        {
+            dart::ScopedStageTimer stepTimer(stageTimers,stageStep);
+            tracker.stepForward();
+        }
 #endif
 
 #ifdef ENABLE_LCM_JOINTS
 #ifdef ENABLE_URDF
-        // get reported Valkyrie configuration
-        val_pose.setReducedArticulation(lcm_joints.getJointsNameValue());
+        // get consistent snapshot of reported Valkyrie configuration
+        lcm_joints.snapshot(val_pose);
         // transform coordinate origin to camera image centre
+        val.setPose(val_pose);
         dart::SE3 Tmc = val.getTransformModelToFrame(val_cam_frame_id);
         val_pose.setTransformModelToCamera(Tmc);
 #endif
 #endif
 
 #ifdef ENABLE_URDF
-        if(pangolin::Pushed(resetRobotPose) || useReportedPose) {
+        if(frameParams.requests.resetRobotPose || frameParams.useReportedPose) {
 #ifdef ENABLE_LCM_JOINTS
-            val_torso_pose.setReducedArticulation(lcm_joints.getJointsNameValue());
+            // reported configuration of this frame is already stored in val_pose
+            val_torso_joint_map.update(val_pose, val_torso_pose);
+            val_torso_joint_map.gather(val_pose.getReducedArticulation(), val_torso_pose.getReducedArticulation());
 #endif
             val_torso_mm.setPose(val_torso_pose);
             dart::SE3 Tmc = val_torso_mm.getTransformModelToFrame(val_torso_cam_frame_id);
@@ -908,61 +1365,67 @@ int main(int argc, char *argv[]) {
 #endif
 
 #ifdef ENABLE_JUSTIN
-        static pangolin::Var<std::string> trackingModeStr("ui.mode");
-        trackingModeStr = getTrackingModeString(trackingMode);
+        opts.lambdaIntersection[0 + 3*0] = frameParams.lambdaIntersection; // right
+        opts.lambdaIntersection[2 + 3*2] = frameParams.lambdaIntersection; // left
 
-        opts.lambdaIntersection[0 + 3*0] = lambdaIntersection; // right
-        opts.lambdaIntersection[2 + 3*2] = lambdaIntersection; // left
+        opts.lambdaIntersection[1 + 3*0] = frameParams.lambdaIntersection; // object->right
+        opts.lambdaIntersection[0 + 3*1] = frameParams.lambdaIntersection; // right->object
 
-        opts.lambdaIntersection[1 + 3*0] = lambdaIntersection; // object->right
-        opts.lambdaIntersection[0 + 3*1] = lambdaIntersection; // right->object
+        opts.lambdaIntersection[1 + 3*2] = frameParams.lambdaIntersection; // object->left
+        opts.lambdaIntersection[2 + 3*1] = frameParams.lambdaIntersection; // left->object
 
-        opts.lambdaIntersection[1 + 3*2] = lambdaIntersection; // object->left
-        opts.lambdaIntersection[2 + 3*1] = lambdaIntersection; // left->object
+        if (frameParams.requests.table) {
+            trackedTableNorm = frameParams.tableNorm;
+            trackedTableIntercept = frameParams.tableIntercept;
+        }
 #endif
 
-        opts.focalLength = focalLength;
-        opts.normThreshold = normalThreshold;
+        opts.focalLength = frameParams.focalLength;
+        opts.normThreshold = frameParams.normalThreshold;
         for (int m=0; m<tracker.getNumModels(); ++m) {
-            opts.distThreshold[m] = distanceThreshold;
+            opts.distThreshold[m] = frameParams.distanceThreshold;
         }
         opts.regularization[0] = opts.regularization[1] = opts.regularization[2] = 0.01;
 #ifdef ENABLE_JUSTIN
-        opts.regularizationScaled[0] = handRegularization;
-        opts.regularizationScaled[1] = objectRegularization;
-        opts.regularizationScaled[2] = handRegularization;
+        opts.regularizationScaled[0] = frameParams.handRegularization;
+        opts.regularizationScaled[1] = frameParams.objectRegularization;
+        opts.regularizationScaled[2] = frameParams.handRegularization;
 #endif
 #ifdef JUSTIN
-        opts.planeOffset[2] = planeOffset;
+        opts.planeOffset[2] = frameParams.planeOffset;
 #endif
-        opts.lambdaObsToMod = lambdaObsToMod;
-        opts.lambdaModToObs = lambdaModToObs;
+        opts.lambdaObsToMod = frameParams.lambdaObsToMod;
+        opts.lambdaModToObs = frameParams.lambdaModToObs;
 #ifdef JUSTIN
-        opts.planeOffset[0] = planeOffset;
-#endif
-        opts.debugObsToModDA = pointColoringObs == PointColoringDA || (debugImg == DebugObsToModDA);
-        opts.debugModToObsDA = debugImg == DebugModToObsDA;
-        opts.debugObsToModErr = ((pointColoringObs == PointColoringErr) || (debugImg == DebugObsToModErr));
-        opts.debugModToObsErr = ((pointColoringPred == PointColoringErr) || (debugImg == DebugModToObsErr));
-        opts.debugJTJ = (debugImg == DebugJTJ);
-        opts.numIterations = itersPerFrame;
-
-        if (pangolin::Pushed(stepVideoBack)) {
+        opts.planeOffset[0] = frameParams.planeOffset;
+#endif
+        // debug images are only computed for display
+        opts.debugObsToModDA = !headless && (frameParams.pointColoringObs == PointColoringDA || (frameParams.debugImg == DebugObsToModDA));
+        opts.debugModToObsDA = !headless && (frameParams.debugImg == DebugModToObsDA);
+        opts.debugObsToModErr = !headless && ((frameParams.pointColoringObs == PointColoringErr) || (frameParams.debugImg == DebugObsToModErr));
+        opts.debugModToObsErr = !headless && ((frameParams.pointColoringPred == PointColoringErr) || (frameParams.debugImg == DebugModToObsErr));
+        opts.debugJTJ = !headless && (frameParams.debugImg == DebugJTJ);
+        iterationPolicy.setMaxIterations(frameParams.itersPerFrame);
+        iterationPolicy.setMinUpdate(frameParams.minUpdateNorm);
+        iterationPolicy.setMinErrorChange(frameParams.minErrorChange);
+        iterationPolicy.setBudget(frameParams.frameBudget);
+
+        if (frameParams.requests.stepVideoBack) {
             tracker.stepBackward();
         }
 
-        bool iteratePushed = Pushed(iterateButton);
+        bool iteratePushed = frameParams.requests.iterate;
 
-        if (pangolinFrame % fpsWindow == 0) {
+        if (trackingFrame % fpsWindow == 0) {
             pangolin::basetime time = pangolin::TimeNow();
-            if (trackFromVideo) {
+            if (frameParams.trackFromVideo) {
                 static int totalFrames = 0;
                 static double totalTime = 0;
                 totalFrames += fpsWindow;
                 totalTime += pangolin::TimeDiff_s(lastTime,time);
-                fps = totalFrames / totalTime;
+                trackingFps = totalFrames / totalTime;
             } else {
-                fps = fpsWindow / pangolin::TimeDiff_s(lastTime,time);
+                trackingFps = fpsWindow / pangolin::TimeDiff_s(lastTime,time);
             }
             lastTime = time;
         }
@@ -975,75 +1438,136 @@ int main(int argc, char *argv[]) {
         //////////////////////////////////////////////////////////////////////////////////////////////////////////
         {
 
-            static pangolin::Var<bool> filteredNorms("ui.filteredNorms",false,true);
-            static pangolin::Var<bool> filteredVerts("ui.filteredVerts",false,true);
-
-            if (filteredNorms.GuiChanged()) {
-                tracker.setFilteredNorms(filteredNorms);
-            } else if (filteredVerts.GuiChanged()) {
-                tracker.setFilteredVerts(filteredVerts);
-            } else if (sigmaDepth.GuiChanged()) {
-                tracker.setSigmaDepth(sigmaDepth);
-            } else if (sigmaPixels.GuiChanged()) {
-                tracker.setSigmaPixels(sigmaPixels);
+            if (frameParams.requests.filteredNorms) {
+                tracker.setFilteredNorms(frameParams.filteredNorms);
+            }
+            if (frameParams.requests.filteredVerts) {
+                tracker.setFilteredVerts(frameParams.filteredVerts);
+            }
+            if (frameParams.requests.sigmaDepth) {
+                tracker.setSigmaDepth(frameParams.sigmaDepth);
+            }
+            if (frameParams.requests.sigmaPixels) {
+                tracker.setSigmaPixels(frameParams.sigmaPixels);
             }
 
-            // update pose based on sliders
-            if (sliderControlled) {
-                for (int m=0; m<tracker.getNumModels(); ++m) {
+            // update poses of models whose sliders were moved
+            if (frameParams.sliderControlled) {
+                poseSliders.applySliderChanges([&](const int m, const float * sliders) {
                     for (int i=0; i<tracker.getPose(m).getReducedArticulatedDimensions(); ++i) {
-                        tracker.getPose(m).getReducedArticulation()[i] = *poseVars[m][i+6];
+                        tracker.getPose(m).getReducedArticulation()[i] = sliders[i+6];
                     }
-                    tracker.getPose(m).setTransformModelToCamera(dart::SE3Fromse3(dart::se3(*poseVars[m][0],*poseVars[m][1],*poseVars[m][2],0,0,0))*
-                            dart::SE3Fromse3(dart::se3(0,0,0,*poseVars[m][3],*poseVars[m][4],*poseVars[m][5])));
+                    tracker.getPose(m).setTransformModelToCamera(dart::SE3Fromse3(dart::se3(sliders[0],sliders[1],sliders[2],0,0,0))*
+                            dart::SE3Fromse3(dart::se3(0,0,0,sliders[3],sliders[4],sliders[5])));
                     tracker.updatePose(m);
-                }
+                });
             }
 
             // run optimization method
-            if (trackFromVideo || iteratePushed ) {
+            if (frameParams.trackFromVideo || iteratePushed ) {
 
                 // workaround: we need to wait 1 frame before starting optimization
                 // otherwise, the no movement prior produces a wrong update
-                if(pangolinFrame>1)
-                    tracker.optimizePoses();
+                if(trackingFrame>1) {
+                    dart::ScopedStageTimer optimizeTimer(stageTimers,stageOptimize);
+                    gatherPoseParameters(policyParams);
+                    if (iterationPolicy.beginFrame(policyParams.data(),policyParams.size())) {
+                        float errObsToMod, errModToObs;
+                        if (iterationPolicy.stopsEarly()) {
+                            // one iteration per call, the policy decides after each whether to continue
+                            opts.numIterations = 1;
+                            do {
+                                tracker.optimizePoses();
+                                gatherPoseParameters(policyParams);
+                                sumPointErrors(errObsToMod,errModToObs);
+                            } while (iterationPolicy.endIteration(policyParams.data(),errObsToMod + errModToObs));
+                        } else {
+                            // all iterations in one call, the solver sets up the frame once
+                            opts.numIterations = frameParams.itersPerFrame;
+                            tracker.optimizePoses();
+                            gatherPoseParameters(policyParams);
+                            sumPointErrors(errObsToMod,errModToObs);
+                            iterationPolicy.endIterations(policyParams.data(),errObsToMod + errModToObs);
+                        }
+                    }
+                    snapshot.iterations = frameResult.iterations = iterationPolicy.iterations();
+                    snapshot.stopReason = frameResult.stopReason = iterationPolicy.stopReason();
+                    iterationSum += iterationPolicy.iterations();
+                    ++iterationFrames;
+                }
 
                 // update accumulated info
-                for (int m=0; m<tracker.getNumModels(); ++m) {
+                {
+                    dart::ScopedStageTimer dampingTimer(stageTimers,stageDamping);
+                    for (int m=0; m<tracker.getNumModels(); ++m) {
 #ifdef ENABLE_JUSTIN
-                    if (m == 1 && trackingMode == ModeIntermediate) { continue; }
-#endif
-                    const Eigen::MatrixXf & JTJ = *tracker.getOptimizer()->getJTJ(m);
-                    if (JTJ.rows() == 0) { continue; }
-                    Eigen::MatrixXf & dampingMatrix = tracker.getDampingMatrix(m);
-                    for (int i=0; i<3; ++i) {
-                        dampingMatrix(i,i) = std::min((float)maxTranslationDamping,dampingMatrix(i,i) + infoAccumulationRate*JTJ(i,i));
-                    }
-                    for (int i=3; i<tracker.getPose(m).getReducedDimensions(); ++i) {
-                        dampingMatrix(i,i) = std::min((float)maxRotationDamping,dampingMatrix(i,i) + infoAccumulationRate*JTJ(i,i));
+                        if (m == 1 && trackingMode == ModeIntermediate) { continue; }
+#endif
+                        const Eigen::MatrixXf & JTJ = *tracker.getOptimizer()->getJTJ(m);
+                        if (JTJ.rows() == 0) { continue; }
+                        Eigen::MatrixXf & dampingMatrix = tracker.getDampingMatrix(m);
+                        for (int i=0; i<3; ++i) {
+                            dampingMatrix(i,i) = std::min(frameParams.maxTranslationDamping,dampingMatrix(i,i) + frameParams.infoAccumulationRate*JTJ(i,i));
+                        }
+                        for (int i=3; i<tracker.getPose(m).getReducedDimensions(); ++i) {
+                            dampingMatrix(i,i) = std::min(frameParams.maxRotationDamping,dampingMatrix(i,i) + frameParams.infoAccumulationRate*JTJ(i,i));
+                        }
                     }
                 }
 
-                float errPerObsPoint = optimizer.getErrPerObsPoint(1,0);
-                float errPerModPoint = optimizer.getErrPerModPoint(1,0);
+                float errPerObsPoint, errPerModPoint;
+                sumPointErrors(errPerObsPoint,errPerModPoint);
 
-                infoLog.Log(errPerObsPoint,errPerObsPoint+errPerModPoint,stabilityThreshold,resetInfoThreshold);
+                snapshot.optimized = true;
+                snapshot.errObsToMod = frameResult.errObsToMod = errPerObsPoint;
+                snapshot.errModToObs = frameResult.errModToObs = errPerModPoint;
 
-                for (int m=0; m<tracker.getNumModels(); ++m) {
-                    for (int i=0; i<tracker.getPose(m).getReducedArticulatedDimensions(); ++i) {
-                        *poseVars[m][i+6] = tracker.getPose(m).getReducedArticulation()[i];
+                if (!headless) {
+                    for (int m=0; m<tracker.getNumModels(); ++m) {
+                        poseSliders.publish(m,tracker.getPose(m));
                     }
-                    dart::SE3 T_cm = tracker.getPose(m).getTransformModelToCamera();
-                    *poseVars[m][0] = T_cm.r0.w; T_cm.r0.w = 0;
-                    *poseVars[m][1] = T_cm.r1.w; T_cm.r1.w = 0;
-                    *poseVars[m][2] = T_cm.r2.w; T_cm.r2.w = 0;
-                    dart::se3 t_cm = dart::se3FromSE3(T_cm);
-                    *poseVars[m][3] = t_cm.p[3];
-                    *poseVars[m][4] = t_cm.p[4];
-                    *poseVars[m][5] = t_cm.p[5];
                 }
 
+                // RMS deviation of tracked from reported joint angles
 #ifdef ENABLE_LCM_JOINTS
+                {
+                    val_torso_joint_map.update(val_pose, val_torso_pose);
+                    const float * tracked = val_torso_pose.getReducedArticulation();
+                    std::copy(tracked, tracked+reportedTorsoJoints.size(), reportedTorsoJoints.begin());
+                    val_torso_joint_map.gather(val_pose.getReducedArticulation(), reportedTorsoJoints.data());
+                    float sqErr = 0;
+                    for (uint i=0; i<reportedTorsoJoints.size(); ++i) {
+                        sqErr += (tracked[i]-reportedTorsoJoints[i])*(tracked[i]-reportedTorsoJoints[i]);
+                    }
+                    if (val_torso_joint_map.numMapped() > 0) {
+                        frameResult.jointError = std::sqrt(sqErr/val_torso_joint_map.numMapped());
+                        jointErrorSum += frameResult.jointError;
+                        ++jointErrorFrames;
+                    }
+                }
+#endif
+#ifdef ENABLE_JUSTIN
+                {
+                    const float * reported = reportedJointAngles[depthSource->getFrame()];
+                    const int rightDims = rightHandPose.getReducedArticulatedDimensions();
+                    const int leftDims = leftHandPose.getReducedArticulatedDimensions();
+                    float sqErr = 0;
+                    for (int i=0; i<rightDims; ++i) {
+                        const float d = rightHandPose.getReducedArticulation()[i] - reported[7+i];
+                        sqErr += d*d;
+                    }
+                    for (int i=0; i<leftDims; ++i) {
+                        const float d = leftHandPose.getReducedArticulation()[i] - reported[7+15+7+i];
+                        sqErr += d*d;
+                    }
+                    frameResult.jointError = std::sqrt(sqErr/(rightDims+leftDims));
+                    jointErrorSum += frameResult.jointError;
+                    ++jointErrorFrames;
+                }
+#endif
+
+#ifdef ENABLE_LCM_JOINTS
+                dart::ScopedStageTimer publishTimer(stageTimers,stagePublish);
                 // publish optimized pose
                 lcm_robot_state.publish_estimate();
                 // publish frame poses of reported and estimated model
@@ -1055,447 +1579,205 @@ int main(int argc, char *argv[]) {
 
         }
 
-        //////////////////////////////////////////////////////////////////////////////////////////////////////////
-        //                                                                                                      //
-        // Render this frame                                                                                    //
-        //                                                                                                      //
-        //////////////////////////////////////////////////////////////////////////////////////////////////////////
-
-        glClearColor (1.0, 1.0, 1.0, 1.0);
-        glShadeModel (GL_SMOOTH);
-        float4 lightPosition = make_float4(normalize(make_float3(-0.4405,-0.5357,-0.619)),0);
-        glLightfv(GL_LIGHT0, GL_POSITION, (float*)&lightPosition);
-
-        camDisp.ActivateScissorAndClear(camState);
-
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_LIGHT0);
-        glEnable(GL_NORMALIZE);
-        glEnable(GL_LIGHTING);
-
-        camDisp.ActivateAndScissor(camState);
-
-        glPushMatrix();
-#ifdef ENABLE_URDF
-        //static pangolin::Var<bool> showAxes("ui.showAxes",true,true);
-        static pangolin::Var<bool> showAxes("ui.showAxes",false,true);
-        if(showAxes) {
-            // draw coordinates axes, x: red, y: green, z: blue
-            pangolin::glDrawAxis(0.5);
-            glColor3f(0,0,1);
-            pangolin::glDraw_z0(0.01, 10);
-        }
-#endif
-
-        if (showCameraPose) {
-
-            glColor3f(0,0,0);
-            glPushMatrix();
-
-//            glRotatef(180,0,1,0);
-//            glutSolidCube(0.02);
+        // -=-=-=- snapshot of this frame for rendering -=-=-=-
+        if (!headless) {
+            dart::ScopedStageTimer snapshotTimer(stageTimers,stageSnapshot);
+            snapshot.frame = trackingFrame;
+            snapshot.fps = trackingFps;
+            snapshot.clearBuffers();
 
-//            glTranslatef(0,0,-0.02);
-//            glutSolidCone(0.0125,0.02,10,1);
-
-            glPopMatrix();
-
-        }
-
-        glColor4ub(0xff,0xff,0xff,0xff);
-        if (showEstimatedPose) {
-
-            glEnable(GL_COLOR_MATERIAL);
-
-            glPushMatrix();
-
-            if (showVoxelized) {
-                glColor3f(0.2,0.3,1.0);
-
-                for (int m=0; m<tracker.getNumModels(); ++m) {
-//                for (int m=1; m<=1; m+=10) {
-                    tracker.updatePose(m);
-                    tracker.getModel(m).renderVoxels(levelSet);
-                }
-            }
-            else{
-                for (int m=0; m<tracker.getNumModels(); ++m) {
-                    tracker.updatePose(m);
-                    tracker.getModel(m).render();
-                }
+            // poses of the tracked models and the reported pose
+            snapshot.modelTransforms.resize(tracker.getNumModels());
+            snapshot.modelArticulations.clear();
+            for (int m=0; m<tracker.getNumModels(); ++m) {
+                dart::Pose & pose = tracker.getPose(m);
+                snapshot.modelTransforms[m] = pose.getTransformModelToCamera();
+                snapshot.modelArticulations.insert(snapshot.modelArticulations.end(),pose.getReducedArticulation(),pose.getReducedArticulation()+pose.getReducedArticulatedDimensions());
             }
-
-            glPopMatrix();
-
-        }
-
-        if (showReported) {
-            glColor3ub(0xfa,0x85,0x7c);
-            glEnable(GL_COLOR_MATERIAL);
-
-#ifdef ENABLE_JUSTIN
-            memcpy(spaceJustinPose.getReducedArticulation(),reportedJointAngles[depthSource->getFrame()],spaceJustinPose.getReducedArticulatedDimensions()*sizeof(float));
-            spaceJustinPose.projectReducedToFull();
-            spaceJustin.setPose(spaceJustinPose);
-            spaceJustin.renderWireframe();
-#endif
-
 #ifdef ENABLE_URDF
-            // render Valkyrie reported state as wireframe model, origin is the camera centre
-            val.setPose(val_pose);
-            val.renderWireframe();
+            snapshot.reportedTransform = val_pose.getTransformModelToCamera();
+            snapshot.reportedArticulation.assign(val_pose.getReducedArticulation(),val_pose.getReducedArticulation()+val_pose.getReducedArticulatedDimensions());
 #endif
-
-            // glColor3ub(0,0,0);
-            // glutSolidSphere(0.02,10,10);
-        }
-
-        glPointSize(1.0f);
-
-#ifdef JUSTIN
-        if (showTablePlane) {
-
-            float3 normal = normalize(make_float3(tableNormX,tableNormY,tableNormZ));
-            tableNormX = normal.x;
-            tableNormY = normal.y;
-            tableNormZ = normal.z;
-
-            float3 ipv1 = cross(normal,normal.x == 1 ? make_float3(0,1,0) : make_float3(1,0,0));
-            float3 ipv2 = cross(normal,ipv1);
-
-            float3 pts[4] = { operator+(operator *( 0.5,ipv1),operator *( 0.5,ipv2)),
-                              operator+(operator *( 0.5,ipv1),operator *(-0.5,ipv2)),
-                              operator+(operator *(-0.5,ipv1),operator *(-0.5,ipv2)),
-                              operator+(operator *(-0.5,ipv1),operator *( 0.5,ipv2))};
-
-            glColor3ub(120,100,100);
-            glBegin(GL_QUADS);
-            glNormal3f(-normal.x,-normal.y,-normal.z);
-            for (int i=0; i<4; ++i) {
-                glVertex3f(tableIntercept*normal.x + pts[i].x,
-                           tableIntercept*normal.y + pts[i].y,
-                           tableIntercept*normal.z + pts[i].z);
+#ifdef ENABLE_JUSTIN
+            {
+                const float * reported = reportedJointAngles[depthSource->getFrame()];
+                snapshot.reportedTransform = spaceJustinPose.getTransformModelToCamera();
+                snapshot.reportedArticulation.assign(reported,reported+spaceJustinPose.getReducedArticulatedDimensions());
             }
-            glEnd();
-
-        }
 #endif
-
-        if (showObsSdf) {
-            static pangolin::Var<float> levelSet("ui.levelSet",0,-10,10);
-
-            for (int m=0; m<tracker.getNumModels(); ++m) {
-
-                glPushMatrix();
-                dart::glMultSE3(tracker.getModel(m).getTransformModelToCamera());
-                tracker.getModel(m).syncObsSdfDeviceToHost();
-                dart::Grid3D<float> * obsSdf = tracker.getModel(m).getObsSdf();
-                tracker.getModel(m).renderSdf(*obsSdf,levelSet);
-                glPopMatrix();
-            }
-        }
-
-        if (showTrackedPoints) {
-
-            glPointSize(4.0f);
-            glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudVbo);
-            glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(float4),tracker.getHostVertMap(),GL_DYNAMIC_DRAW_ARB);
-
-            glEnableClientState(GL_VERTEX_ARRAY);
-            glDisableClientState(GL_NORMAL_ARRAY);
-            glVertexPointer(4, GL_FLOAT, 0, 0);
-
-            if(showPointColour)
-                pointColoringObs = PointColoringRGB;
-            else if(pointColoringObs == PointColoringRGB)
-                pointColoringObs = PointColoringNone;
-
-            switch (pointColoringObs) {
-            case PointColoringNone:
-                glColor3f(0.25,0.25,0.25);
-                glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudNormVbo);
-                glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(float4),tracker.getHostNormMap(),GL_DYNAMIC_DRAW_ARB);
-
-                glNormalPointer(GL_FLOAT, 4*sizeof(float), 0);
-                glEnableClientState(GL_NORMAL_ARRAY);
-                break;
-            case PointColoringRGB:
-                glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudColorVbo);
-                glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(uchar3),depthSource->getColor(),GL_DYNAMIC_DRAW_ARB);
-                glColorPointer(3,GL_UNSIGNED_BYTE, 0, 0);
-                glEnableClientState(GL_COLOR_ARRAY);
-                glDisable(GL_LIGHTING);
-                break;
-            case PointColoringErr:
-                {
-                    static float errorMin = 0.0;
-                    static float errorMax = 0.1;
-                    float * dErr;
-                    cudaMalloc(&dErr,depthWidth*depthHeight*sizeof(float));
-                    dart::imageSquare(dErr,tracker.getDeviceDebugErrorObsToMod(),depthWidth,depthHeight);
-                    dart::colorRampHeatMapUnsat(imgDepthSize.devicePtr(),dErr,depthWidth,depthHeight,errorMin,errorMax);
-                    cudaFree(dErr);
-                    imgDepthSize.syncDeviceToHost();
-                    glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudColorVbo);
-                    glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(uchar3),imgDepthSize.hostPtr(),GL_DYNAMIC_DRAW_ARB);
-                    glColorPointer(3,GL_UNSIGNED_BYTE, 0, 0);
-                    glEnableClientState(GL_COLOR_ARRAY);
-                    glDisable(GL_LIGHTING);
-                }
-                break;
-            case PointColoringDA:
-                {
-                    const int * dDebugDA = tracker.getDeviceDebugDataAssociationObsToMod();
-                    dart::colorDataAssociationMultiModel(imgDepthSize.devicePtr(),dDebugDA,allSdfColors.devicePtr(),depthWidth,depthHeight);
-                    imgDepthSize.syncDeviceToHost();
-                    glBindBufferARB(GL_ARRAY_BUFFER_ARB,pointCloudColorVbo);
-                    glBufferDataARB(GL_ARRAY_BUFFER_ARB,depthWidth*depthHeight*sizeof(uchar3),imgDepthSize.hostPtr(),GL_DYNAMIC_DRAW_ARB);
-                    glColorPointer(3,GL_UNSIGNED_BYTE, 0, 0);
-                    glEnableClientState(GL_COLOR_ARRAY);
-                    glDisable(GL_LIGHTING);
-                }
-                break;
-            }
-
-            glDrawArrays(GL_POINTS,0,depthWidth*depthHeight);
-            glBindBuffer(GL_ARRAY_BUFFER_ARB,0);
-
-            glDisableClientState(GL_VERTEX_ARRAY);
-            glDisableClientState(GL_COLOR_ARRAY);
-            glDisableClientState(GL_NORMAL_ARRAY);
-
-            glPointSize(1.0f);
-
-        }
-
+#ifdef ENABLE_JUSTIN
+            snapshot.mode = trackingMode;
+            snapshot.plane = make_float4(trackedTableNorm,trackedTableIntercept);
+#endif
 #ifdef USE_CONTACT_PRIOR
-        static pangolin::Var<bool> showFingerContacts("ui.showContacts",true,true);
-        if (showFingerContacts) {
-
-            glPointSize(10.f);
-            glBegin(GL_POINTS);
+            snapshot.contacts.assign(contactState,contactState+10);
             for (int i=0; i<contactPriors.size(); ++i) {
-
-                if (*contactVars[i]) {
-
+                if (contactState[i]) {
                     const int model = contactPriors[i]->getSourceModel();
                     const int sdfNum = contactPriors[i]->getSourceSdfNum();
                     const int frameNum = tracker.getModel(model).getSdfFrameNumber(sdfNum);
                     const float3 contactPoint = contactPriors[i]->getContactPoint();
-
-                    float4 contact_c = tracker.getModel(model).getTransformFrameToCamera(frameNum)*make_float4(contactPoint,1);
-
-                    glColor3f(1.0,0,0);
-                    glVertex3fv(&contact_c.x);
-
+                    snapshot.contactPoints.push_back(tracker.getModel(model).getTransformFrameToCamera(frameNum)*make_float4(contactPoint,1));
                 }
             }
-            glEnd();
-
-        }
 #endif
 
-        if (showPredictedPoints) {
-
-            glPointSize(4.0f);
-
-            const float4 * dPredictedVertMap = tracker.getDevicePredictedVertMap();
-            const int nPoints = tracker.getPredictionWidth()*tracker.getPredictionHeight();
-            float4 * hPredictedVertMap = new float4[nPoints];
-            cudaMemcpy(hPredictedVertMap,dPredictedVertMap,nPoints*sizeof(float4),cudaMemcpyDeviceToHost);
-
-
-            glDisable(GL_LIGHTING);
-            glBegin(GL_POINTS);
-
-            if (pointColoringPred == PointColoringErr) {
-                static pangolin::Var<float> errMin("ui.errMin",0,0,0.05);
-                static pangolin::Var<float> errMax("ui.errMax",0.01,0,0.05);
-                dart::MirroredVector<uchar3> debugImg(tracker.getPredictionWidth()*tracker.getPredictionHeight());
-                dart::colorRampHeatMapUnsat(debugImg.devicePtr(),
-                                            tracker.getDeviceDebugErrorModToObs(),
-                                            depthWidth,depthHeight,
-                                            errMin,errMax);
-                debugImg.syncDeviceToHost();
-
-                for (int i=0; i<nPoints; ++i) {
-                    if (hPredictedVertMap[i].z > 0) {
-                        uchar3 color = debugImg.hostPtr()[i];
-                        glColor3ubv((unsigned char*)&color);
-                        glVertex3f(hPredictedVertMap[i].x,hPredictedVertMap[i].y,hPredictedVertMap[i].z);
-                    }
+            if (frameParams.showObsSdf) {
+                snapshot.obsSdfs.resize(tracker.getNumModels());
+                for (int m=0; m<tracker.getNumModels(); ++m) {
+                    tracker.getModel(m).syncObsSdfDeviceToHost();
+                    const dart::Grid3D<float> * obsSdf = tracker.getModel(m).getObsSdf();
+                    dart::TrackingSnapshot::Sdf & sdf = snapshot.obsSdfs[m];
+                    sdf.dim = obsSdf->dim;
+                    sdf.offset = obsSdf->offset;
+                    sdf.resolution = obsSdf->resolution;
+                    sdf.data.assign(obsSdf->data,obsSdf->data+obsSdf->dim.x*obsSdf->dim.y*obsSdf->dim.z);
                 }
+            }
 
-            } else {
+            if (frameParams.showTrackedPoints) {
+                const float4 * hVertMap = tracker.getHostVertMap();
+                snapshot.obsVertMap.assign(hVertMap,hVertMap+depthWidth*depthHeight);
+                dart::PointCloudStream::compactValidPoints(hVertMap,depthWidth*depthHeight,snapshot.obsIndices);
 
-                for (int i=0; i<nPoints; ++i) {
-                    if (hPredictedVertMap[i].z > 0) {
-                        int id = round(hPredictedVertMap[i].w);
-                        int model = id >> 16;
-                        int sdf = id & 65535;
-                        uchar3 color = tracker.getModel(model).getSdfColor(sdf);
-                        glColor3ubv((unsigned char*)&color);
-                        glVertex3f(hPredictedVertMap[i].x,hPredictedVertMap[i].y,hPredictedVertMap[i].z);
+                switch (frameParams.pointColoringObs) {
+                case PointColoringNone:
+                    {
+                        const float4 * hNormMap = tracker.getHostNormMap();
+                        snapshot.obsNormMap.assign(hNormMap,hNormMap+depthWidth*depthHeight);
                     }
+                    break;
+                case PointColoringRGB:
+                    snapshot.obsColors.assign(depthSource->getColor(),depthSource->getColor()+depthWidth*depthHeight);
+                    break;
+                case PointColoringErr:
+                    {
+                        static float errorMin = 0.0;
+                        static float errorMax = 0.1;
+                        float * dSquaredErr = frameArena.device<float>(depthWidth*depthHeight);
+                        dart::backend::colorSquaredRampHeatMap(imgDepthSize.devicePtr(),tracker.getDeviceDebugErrorObsToMod(),depthWidth,depthHeight,errorMin,errorMax,dSquaredErr);
+                        imgDepthSize.syncDeviceToHost();
+                        snapshot.obsColors.assign(imgDepthSize.hostPtr(),imgDepthSize.hostPtr()+depthWidth*depthHeight);
+                    }
+                    break;
+                case PointColoringDA:
+                    {
+                        const int * dDebugDA = tracker.getDeviceDebugDataAssociationObsToMod();
+                        dart::backend::colorDataAssociation(imgDepthSize.devicePtr(),dDebugDA,allSdfColors.devicePtr(),depthWidth,depthHeight);
+                        imgDepthSize.syncDeviceToHost();
+                        snapshot.obsColors.assign(imgDepthSize.hostPtr(),imgDepthSize.hostPtr()+depthWidth*depthHeight);
+                    }
+                    break;
                 }
             }
 
-            glEnd();
-            delete [] hPredictedVertMap;
-
-            glPointSize(1.0f);
-        }
-
-        if (showCollisionClouds) {
-            glPointSize(10);
-            glColor3f(0,0,1.0f);
-            glDisable(GL_LIGHTING);
-            glBegin(GL_POINTS);
-            for (int m=0; m<tracker.getNumModels(); ++m) {
-                const float4 * collisionCloud = tracker.getCollisionCloud(m);
-                for (int i=0; i<tracker.getCollisionCloudSize(m); ++i) {
-                    int grid = round(collisionCloud[i].w);
-                    int frame = tracker.getModel(m).getSdfFrameNumber(grid);
-                    float4 v = tracker.getModel(m).getTransformModelToCamera()*
-                               tracker.getModel(m).getTransformFrameToModel(frame)*
-                               make_float4(make_float3(collisionCloud[i]),1.0);
-                    glVertex3fv((float*)&v);
+            if (frameParams.showPredictedPoints) {
+                snapshot.predVertMap.resize(predWidth*predHeight);
+                dart::backend::copyToHost(snapshot.predVertMap.data(),tracker.getDevicePredictedVertMap(),predWidth*predHeight*sizeof(float4));
+
+                if (frameParams.pointColoringPred == PointColoringErr) {
+                    dart::backend::colorRampHeatMap(imgPredSize.devicePtr(),
+                                                    tracker.getDeviceDebugErrorModToObs(),
+                                                    predWidth,predHeight,
+                                                    frameParams.errMin,frameParams.errMax);
+                    imgPredSize.syncDeviceToHost();
+                    snapshot.predColors.assign(imgPredSize.hostPtr(),imgPredSize.hostPtr()+predWidth*predHeight);
                 }
             }
-            glEnd();
-            glEnable(GL_LIGHTING);
-
-            glPointSize(1);
-            glColor3f(1,1,1);
-        }
-
-        glPopMatrix();
 
-        imgDisp.ActivateScissorAndClear();
-        glDisable(GL_LIGHTING);
-        glColor4ub(255,255,255,255);
-
-        switch (debugImg) {
-            case DebugColor:
-            {
-                if (depthSource->hasColor()) {
-                    imgTexDepthSize.Upload(depthSource->getColor(),GL_RGB,GL_UNSIGNED_BYTE);
-                    imgTexDepthSize.RenderToViewport();
+            switch (frameParams.debugImg) {
+                case DebugColor:
+                {
+                    if (depthSource->hasColor()) {
+                        snapshot.depthImage.assign(depthSource->getColor(),depthSource->getColor()+depthWidth*depthHeight);
+                    }
                 }
-            }
-            break;
-        case DebugObsDepth:
-            {
-
-                static const float depthMin = 0.3;
-                static const float depthMax = 1.0;
-
-                //const unsigned short * depth = depthSource->getDepth();
-                const auto * depth = depthSource->getDepth();
+                break;
+            case DebugObsDepth:
+                {
+                    static const float depthMin = 0.3;
+                    static const float depthMax = 1.0;
 
-                for (int i=0; i<depthSource->getDepthWidth()*depthSource->getDepthHeight(); ++i) {
-                    if (depth[i] == 0) {
-                        imgDepthSize[i] = make_uchar3(128,0,0);
-                    } else {
-                        unsigned char g = std::max(0,std::min((int)(255*(depth[i]*depthSource->getScaleToMeters()-depthMin)/(float)(depthMax - depthMin)),255));
-                        imgDepthSize[i] = make_uchar3(g,g,g);
-                    }
+                    dart::host::depthToGray(imgDepthSize.hostPtr(),depthSource->getDepth(),depthWidth*depthHeight,
+                                            depthSource->getScaleToMeters(),depthMin,depthMax,make_uchar3(128,0,0));
 
+                    snapshot.depthImage.assign(imgDepthSize.hostPtr(),imgDepthSize.hostPtr()+depthWidth*depthHeight);
                 }
+                break;
+            case DebugPredictedDepth:
+                {
+                    static const float depthMin = 0.3;
+                    static const float depthMax = 1.0;
 
-                imgTexDepthSize.Upload(imgDepthSize.hostPtr(),GL_RGB,GL_UNSIGNED_BYTE);
-                imgTexDepthSize.RenderToViewport();
-            }
-        case DebugPredictedDepth:
-            {
-                static const float depthMin = 0.3;
-                static const float depthMax = 1.0;
+                    const float4 * dPredictedVertMap = tracker.getDevicePredictedVertMap();
+                    float4 * hPredictedVertMap = frameArena.host<float4>(predWidth*predHeight);
 
-                const float4 * dPredictedVertMap = tracker.getDevicePredictedVertMap();
-                static std::vector<float4> hPredictedVertMap(predWidth*predHeight);
+                    dart::backend::copyToHost(hPredictedVertMap,dPredictedVertMap,predWidth*predHeight*sizeof(float4));
 
-                cudaMemcpy(hPredictedVertMap.data(),dPredictedVertMap,predWidth*predHeight*sizeof(float4),cudaMemcpyDeviceToHost);
+                    // depth is the z component of the predicted vertices
+                    dart::host::depthToGray(imgPredSize.hostPtr(),&hPredictedVertMap[0].z,predWidth*predHeight,
+                                            1.f,depthMin,depthMax,make_uchar3(128,0,0),4);
 
-                for (int i=0; i<predHeight*predWidth; ++i) {
-                    const float depth = hPredictedVertMap[i].z;
-                    if (depth == 0) {
-                        imgPredSize[i] = make_uchar3(128,0,0);
-                    } else {
-                        unsigned char g = std::max(0,std::min((int)(255*(depth-depthMin)/(float)(depthMax - depthMin)),255));
-                        imgPredSize[i] = make_uchar3(g,g,g);
-                    }
+                    snapshot.predImage.assign(imgPredSize.hostPtr(),imgPredSize.hostPtr()+predWidth*predHeight);
                 }
-
-                imgTexPredictionSize.Upload(imgPredSize.hostPtr(),GL_RGB,GL_UNSIGNED_BYTE);
-                imgTexPredictionSize.RenderToViewport();
-            }
-            break;
-        case DebugObsToModDA:
-        {
-            dart::colorDataAssociationMultiModel(imgDepthSize.devicePtr(),
-                                                 tracker.getDeviceDebugDataAssociationObsToMod(),
-                                                 allSdfColors.devicePtr(),depthWidth,depthHeight);\
-            imgDepthSize.syncDeviceToHost();
-            imgTexDepthSize.Upload(imgDepthSize.hostPtr(),GL_RGB,GL_UNSIGNED_BYTE);
-            imgTexDepthSize.RenderToViewport();
-            break;
-        }
-        case DebugModToObsDA:
-        {
-            dart::colorDataAssociationMultiModel(imgPredSize.devicePtr(),
-                                                 tracker.getDeviceDebugDataAssociationModToObs(),
-                                                 allSdfColors.devicePtr(),predWidth,predHeight);\
-            imgPredSize.syncDeviceToHost();
-            imgTexPredictionSize.Upload(imgPredSize.hostPtr(),GL_RGB,GL_UNSIGNED_BYTE);
-            imgTexPredictionSize.RenderToViewport();
-            break;
-        }
-        case DebugObsToModErr:
+                break;
+            case DebugObsToModDA:
             {
-                static const float errMax = 0.01;
-                dart::colorRampHeatMapUnsat(imgDepthSize.devicePtr(),
-                                            tracker.getDeviceDebugErrorObsToMod(),
-                                            depthWidth,depthHeight,
-                                            0.f,errMax);
+                dart::backend::colorDataAssociation(imgDepthSize.devicePtr(),
+                                                    tracker.getDeviceDebugDataAssociationObsToMod(),
+                                                    allSdfColors.devicePtr(),depthWidth,depthHeight);
                 imgDepthSize.syncDeviceToHost();
-                imgTexDepthSize.Upload(imgDepthSize.hostPtr(),GL_RGB,GL_UNSIGNED_BYTE);
-                imgTexDepthSize.RenderToViewport();
+                snapshot.depthImage.assign(imgDepthSize.hostPtr(),imgDepthSize.hostPtr()+depthWidth*depthHeight);
+                break;
             }
-            break;
-        case DebugModToObsErr:
+            case DebugModToObsDA:
             {
-                static const float errMax = 0.01;
-                dart::colorRampHeatMapUnsat(imgPredSize.devicePtr(),
-                                            tracker.getDeviceDebugErrorModToObs(),
-                                            depthWidth,depthHeight,
-                                            0.f,errMax);
+                dart::backend::colorDataAssociation(imgPredSize.devicePtr(),
+                                                    tracker.getDeviceDebugDataAssociationModToObs(),
+                                                    allSdfColors.devicePtr(),predWidth,predHeight);
                 imgPredSize.syncDeviceToHost();
-                imgTexPredictionSize.Upload(imgPredSize.hostPtr(),GL_RGB,GL_UNSIGNED_BYTE);
-                imgTexPredictionSize.RenderToViewport();
+                snapshot.predImage.assign(imgPredSize.hostPtr(),imgPredSize.hostPtr()+predWidth*predHeight);
+                break;
+            }
+            case DebugObsToModErr:
+                {
+                    static const float errMax = 0.01;
+                    dart::backend::colorRampHeatMap(imgDepthSize.devicePtr(),
+                                                    tracker.getDeviceDebugErrorObsToMod(),
+                                                    depthWidth,depthHeight,
+                                                    0.f,errMax);
+                    imgDepthSize.syncDeviceToHost();
+                    snapshot.depthImage.assign(imgDepthSize.hostPtr(),imgDepthSize.hostPtr()+depthWidth*depthHeight);
+                }
+                break;
+            case DebugModToObsErr:
+                {
+                    static const float errMax = 0.01;
+                    dart::backend::colorRampHeatMap(imgPredSize.devicePtr(),
+                                                    tracker.getDeviceDebugErrorModToObs(),
+                                                    predWidth,predHeight,
+                                                    0.f,errMax);
+                    imgPredSize.syncDeviceToHost();
+                    snapshot.predImage.assign(imgPredSize.hostPtr(),imgPredSize.hostPtr()+predWidth*predHeight);
+                }
+                break;
+            case DebugJTJ:
+                snapshot.depthImage.assign(tracker.getOptimizer()->getJTJimg(),tracker.getOptimizer()->getJTJimg()+depthWidth*depthHeight);
+                snapshot.flipDepthImage = true;
+                break;
+            default:
+                break;
             }
-            break;
-        case DebugJTJ:
-            imgTexDepthSize.Upload(tracker.getOptimizer()->getJTJimg(),GL_RGB,GL_UNSIGNED_BYTE);
-            imgTexDepthSize.RenderToViewportFlipY();
-            break;
-        default:
-            break;
-        }
-
-        cudaError_t err = cudaGetLastError();
-        if (err != cudaSuccess) {
-            std::cerr << cudaGetErrorString(err) << std::endl;
-        }
 
-        if(pangolin::Pushed(record)) {
-                pangolin::DisplayBase().RecordOnRender("ffmpeg:[fps=50,bps=8388608,unique_filename]//screencap.avi");
+            snapshots.publish();
         }
 
-        pangolin::FinishFrame();
-
-        if (pangolin::Pushed(stepVideo) || trackFromVideo || pangolinFrame == 1) {
+        if (frameParams.requests.stepVideo || frameParams.trackFromVideo || trackingFrame == 1) {
 #ifdef ENABLE_JUSTIN
-            tracker.stepForward();
+            {
+                dart::ScopedStageTimer stepTimer(stageTimers,stageStep);
+                tracker.stepForward();
+            }
 
             const float * currentReportedPose = reportedJointAngles[depthSource->getFrame()];
             const float * lastReportedPose = (depthSource->getFrame()==0) ? currentReportedPose :  reportedJointAngles[depthSource->getFrame()-1];
@@ -1579,52 +1861,44 @@ int main(int argc, char *argv[]) {
             for (int i=0; i<10; ++i) {
                 bool inContact = (contact[i] > 0);
                 anyContact |= inContact;
-                *contactVars[i] = inContact;
-                contactPriors[i]->setWeight(inContact ? lambdaContact : 0);
+                contactState[i] = inContact;
+                contactPriors[i]->setWeight(inContact ? frameParams.lambdaContact : 0);
             }
 #endif
 
 #ifdef ENABLE_JUSTIN
             // update table based on head movement
             {
-                float4 tableNorm = make_float4(normalize(make_float3(tableNormX,tableNormY,tableNormZ)),0.f);
-                float4 tablePoint = make_float4(make_float3(tableIntercept*tableNorm),1.f); // + make_Float4(0,tableNorm.z,-tableNorm.Y,1.f);
-                tableNorm = T_newc_oldc*tableNorm;
+                float4 norm = make_float4(normalize(trackedTableNorm),0.f);
+                float4 tablePoint = make_float4(make_float3(trackedTableIntercept*norm),1.f); // + make_Float4(0,tableNorm.z,-tableNorm.Y,1.f);
+                norm = T_newc_oldc*norm;
                 tablePoint = T_newc_oldc*tablePoint;
-                tableNormX = tableNorm.x;
-                tableNormY = tableNorm.y;
-                tableNormZ = tableNorm.z;
-                tableIntercept = dot(make_float3(tablePoint),make_float3(tableNorm));
+                trackedTableNorm = make_float3(norm);
+                trackedTableIntercept = dot(make_float3(tablePoint),trackedTableNorm);
             }
 #endif
 
 #ifdef JUSTIN
-            static pangolin::Var<float> planeFitNormThresh("opt.planeNormThresh",0.25,-1,1);
-            static pangolin::Var<float> planeFitDistThresh("opt.planeDistThresh",0.005,0.0001,0.005);
-
-            if (fitTable) {
-                float3 normal = normalize(make_float3(tableNormX,tableNormY,tableNormZ));
-                float intercept = tableIntercept;
+            if (frameParams.fitTable) {
+                float3 normal = normalize(trackedTableNorm);
+                float intercept = trackedTableIntercept;
                 dart::fitPlane(normal,
                                intercept,
                                tracker.getPointCloudSource().getDeviceVertMap(),
                                tracker.getPointCloudSource().getDeviceNormMap(),
                                tracker.getPointCloudSource().getDepthWidth(),
                                tracker.getPointCloudSource().getDepthHeight(),
-                               planeFitDistThresh,
-                               planeFitNormThresh,
+                               frameParams.planeFitDistThresh,
+                               frameParams.planeFitNormThresh,
                                1,
                                500);
 
-                tableNormX = normal.x;
-                tableNormY = normal.y;
-                tableNormZ = normal.z;
-                tableIntercept = intercept;
+                trackedTableNorm = normal;
+                trackedTableIntercept = intercept;
             }
 
-            if (subtractTable) {
-                tracker.subtractPlane(make_float3(tableNormX,tableNormY,tableNormZ),
-                                      tableIntercept,0.005,-1.01);
+            if (frameParams.subtractTable) {
+                tracker.subtractPlane(trackedTableNorm,trackedTableIntercept,0.005,-1.01);
             }
 #endif
 
@@ -1634,20 +1908,20 @@ int main(int argc, char *argv[]) {
             switch (trackingMode) {
             case ModeObjOnTable:
 #ifdef USE_CONTACT_PRIOR
-                if (anyContact || totalPerPointError > resetInfoThreshold) {
+                if (anyContact || totalPerPointError > frameParams.resetInfoThreshold) {
 #else
-                if (totalPerPointError > resetInfoThreshold) {
+                if (totalPerPointError > frameParams.resetInfoThreshold) {
 #endif
                     trackingMode = ModeIntermediate;
                     tracker.getDampingMatrix(1) = Eigen::MatrixXf::Zero(6,6);
                 }
                 break;
             case ModeIntermediate:
-                if (totalPerPointError < stabilityThreshold) {
+                if (totalPerPointError < frameParams.stabilityThreshold) {
 #ifdef USE_CONTACT_PRIOR
                     if (anyContact) {
                         bool contactRight = false;
-                        for (int i=0; i<5; ++i) { contactRight = contactRight || *contactVars[i]; }
+                        for (int i=0; i<5; ++i) { contactRight = contactRight || contactState[i]; }
                         trackingMode = (contactRight ? ModeObjGrasped : ModeObjGraspedLeft);
                     } else {
                         trackingMode = ModeObjOnTable;
@@ -1660,7 +1934,7 @@ int main(int argc, char *argv[]) {
             case ModeObjGrasped:
             case ModeObjGraspedLeft:
 #ifdef USE_CONTACT_PRIOR
-                if (!anyContact || totalPerPointError > resetInfoThreshold) {
+                if (!anyContact || totalPerPointError > frameParams.resetInfoThreshold) {
 #else
                 if (true) {
 #endif
@@ -1674,17 +1948,534 @@ int main(int argc, char *argv[]) {
         } else {
 #ifdef USE_CONTACT_PRIOR
             for (int i=0; i<10; ++i) {
-                bool inContact =  *contactVars[i];
-                contactPriors[i]->setWeight(inContact ? lambdaContact : 0);
+                bool inContact = frameParams.contacts[i];
+                contactState[i] = inContact;
+                contactPriors[i]->setWeight(inContact ? frameParams.lambdaContact : 0);
             }
 #endif
         }
+    };
+
+#ifdef DEPTH_SOURCE_LCM
+    // last depth image that was tracked, images are received in the LCM thread
+    int lastInputFrame = depthSource->getFrame();
+#endif
+
+    // make the image of the next frame available, false at the end of a replayed log, if
+    // no new image arrived within the input timeout in headless mode or if tracking stops
+    // Images of a file sequence are read by stepping the depth source while tracking.
+    auto nextFrame = [&]() -> bool {
+#ifdef DEPTH_SOURCE_LCM
+        if (replay) {
+            const int lastFrame = depthSource->getFrame();
+            return replay->next([&]() { return depthSource->getFrame() != lastFrame; });
+        }
+
+        // track every received image once, instead of the same image again
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point deadline = Clock::now() + std::chrono::microseconds(int64_t(1e6*inputTimeout));
+        while (depthSource->getFrame() == lastInputFrame) {
+            if (quitRequested || stopTracking) {
+                return false;
+            }
+            if (headless && inputTimeout > 0 && Clock::now() > deadline) {
+                std::cerr << "no new depth image within " << inputTimeout << " s" << std::endl;
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        lastInputFrame = depthSource->getFrame();
+#endif
+        return true;
+    };
+
+    // track one frame and record its latency, excluding the wait for input
+    auto trackTimedFrame = [&](const int trackingFrame) {
+        const pangolin::basetime frameStart = pangolin::TimeNow();
+        trackFrame(trackingFrame);
+        const double latency = 1000*pangolin::TimeDiff_s(frameStart,pangolin::TimeNow());
+        frameArena.endFrame();
+        ++stopReasonCounts[frameResult.stopReason];
+
+        if (!reportFile.empty()) {
+            frameLatencies.push_back(latency);
+        }
+        if (frameReport.is_open()) {
+            int64_t logTime = 0;
+#ifdef DEPTH_SOURCE_LCM
+            if (replay) { logTime = replay->timestamp(); }
+#endif
+            frameReport << trackingFrame << "," << logTime << "," << latency << ","
+                        << frameResult.iterations << "," << dart::IterationPolicy::stopReasonName(frameResult.stopReason) << ","
+                        << frameResult.errObsToMod << "," << frameResult.errModToObs << "," << frameResult.jointError << ","
+                        << frameArena.hostFramePeak() << "," << frameArena.deviceFramePeak() << "\n";
+        }
+    };
+
+    if (headless) {
+        for (int trackingFrame=1; !quitRequested && (maxFrames <= 0 || trackingFrame <= maxFrames) && nextFrame(); ++trackingFrame) {
+            trackTimedFrame(trackingFrame);
+            // the parameters sampled at startup are used for all frames
+            frameParams.clearRequests();
+
+            const pangolin::basetime now = pangolin::TimeNow();
+            headlessMaxFrameTime = std::max(headlessMaxFrameTime, pangolin::TimeDiff_s(headlessFrameStart,now));
+            headlessFrameStart = now;
+            ++headlessFrames;
+        }
+    } else {
+        // The UI renders the models in the poses of the snapshots, with models and poses of
+        // its own. Tracked models are rendered by the host models they were added from.
+        std::vector<dart::HostOnlyModel *> renderModels(tracker.getNumModels());
+#ifdef ENABLE_JUSTIN
+        renderModels[0] = &rightHandModel;
+        renderModels[1] = &objectModel;
+        renderModels[2] = &leftHandModel;
+
+        dart::HostOnlyModel spaceJustinReported;
+        dart::readModelXML("../models/spaceJustin/spaceJustinArmsAndHead.xml",spaceJustinReported);
+        spaceJustinReported.computeStructure();
+        dart::Pose spaceJustinReportedPose(justinPoseReduction);
+#endif
+#ifdef ENABLE_URDF
+        renderModels[tracker.getModelIDbyName("valkyrie")] = &val_torso;
+#ifdef WITH_BOTTLE
+        renderModels[tracker.getModelIDbyName("bottle")] = &bottle;
+#endif
+#ifdef WITH_BOX
+        renderModels[tracker.getModelIDbyName("box")] = &box;
+#endif
+#ifdef WITH_RECT
+        renderModels[tracker.getModelIDbyName("rect")] = &object;
+#endif
+
+        dart::HostOnlyModel val_reported = dart::readModelURDF(urdf_model_path, "pelvis");
+        dart::Pose val_reported_pose = nullReductionPose(val_reported);
+#endif
+        std::vector<dart::Pose> renderPoses;
+        for (int m=0; m<tracker.getNumModels(); ++m) {
+            renderPoses.push_back(tracker.getPose(m));
+        }
+
+        // observed SDFs copied from the snapshots
+        std::vector<std::unique_ptr<dart::Grid3D<float> > > obsSdfs(tracker.getNumModels());
+
+        // collision clouds do not change, only the transforms of their frames
+        for (int m=0; m<tracker.getNumModels(); ++m) {
+            dart::MirroredModel & model = tracker.getModel(m);
+            std::vector<int> sdfFrames(model.getNumSdfs());
+            for (int s=0; s<model.getNumSdfs(); ++s) {
+                sdfFrames[s] = model.getSdfFrameNumber(s);
+            }
+            collisionCloudBatch->setModel(m,tracker.getCollisionCloud(m),tracker.getCollisionCloudSize(m),sdfFrames);
+        }
+
+        std::thread trackingThread([&]() {
+            for (int trackingFrame=1; !stopTracking && (maxFrames <= 0 || trackingFrame <= maxFrames); ) {
+                // requests are handled once, values are used until the UI publishes new ones
+                frameParams.clearRequests();
+                // while paused, the current frame is tracked again at the rate of the UI, e.g. to iterate
+                if (!frameParameterHandover.take(frameParams) && !frameParams.trackFromVideo) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
+                }
+                // a new image is only fetched for frames that step the video, as in trackFrame
+                const bool stepsVideo = frameParams.trackFromVideo || frameParams.requests.stepVideo || trackingFrame == 1;
+                if (stepsVideo && !nextFrame()) {
+                    break;
+                }
+                trackTimedFrame(trackingFrame++);
+            }
+        });
+
+        // latest tracking results and sampled parameters, owned by the UI thread
+        dart::TrackingSnapshot snapshot;
+        FrameParameters uiParams;
+
+        // ------------------- main loop ---------------------
+        for (int pangolinFrame=1; !quitRequested && !pangolin::ShouldQuit(); ++pangolinFrame) {
+
+            if (pangolin::HasResized()) {
+                pangolin::DisplayBase().ActivateScissorAndClear();
+            }
+
+            const bool newSnapshot = snapshots.acquire(snapshot);
+            if (newSnapshot) {
+                fps = snapshot.fps;
+
+                if (snapshot.modelTransforms.size() == renderModels.size()) {
+                    const float * articulation = snapshot.modelArticulations.data();
+                    for (uint m=0; m<renderModels.size(); ++m) {
+                        dart::Pose & pose = renderPoses[m];
+                        pose.setTransformModelToCamera(snapshot.modelTransforms[m]);
+                        memcpy(pose.getReducedArticulation(),articulation,pose.getReducedArticulatedDimensions()*sizeof(float));
+                        articulation += pose.getReducedArticulatedDimensions();
+                        pose.projectReducedToFull();
+                        renderModels[m]->setPose(pose);
+                    }
+                }
+#ifdef ENABLE_URDF
+                if ((int)snapshot.reportedArticulation.size() == val_reported_pose.getReducedArticulatedDimensions()) {
+                    val_reported_pose.setTransformModelToCamera(snapshot.reportedTransform);
+                    memcpy(val_reported_pose.getReducedArticulation(),snapshot.reportedArticulation.data(),snapshot.reportedArticulation.size()*sizeof(float));
+                    val_reported_pose.projectReducedToFull();
+                    val_reported.setPose(val_reported_pose);
+                }
+#endif
+#ifdef ENABLE_JUSTIN
+                if ((int)snapshot.reportedArticulation.size() == spaceJustinReportedPose.getReducedArticulatedDimensions()) {
+                    spaceJustinReportedPose.setTransformModelToCamera(snapshot.reportedTransform);
+                    memcpy(spaceJustinReportedPose.getReducedArticulation(),snapshot.reportedArticulation.data(),snapshot.reportedArticulation.size()*sizeof(float));
+                    spaceJustinReportedPose.projectReducedToFull();
+                    spaceJustinReported.setPose(spaceJustinReportedPose);
+                }
+#endif
+                for (uint m=0; m<snapshot.obsSdfs.size(); ++m) {
+                    const dart::TrackingSnapshot::Sdf & sdf = snapshot.obsSdfs[m];
+                    if (sdf.data.empty()) { continue; }
+                    if (!obsSdfs[m]) {
+                        obsSdfs[m].reset(new dart::Grid3D<float>(sdf.dim,sdf.offset,sdf.resolution));
+                    }
+                    memcpy(obsSdfs[m]->data,sdf.data.data(),sdf.data.size()*sizeof(float));
+                }
+#ifdef ENABLE_JUSTIN
+                trackingModeStr = getTrackingModeString(TrackingMode(snapshot.mode));
+#endif
+                // while tracking, the table and contacts follow the tracked frames
+                if (trackFromVideo) {
+#ifdef JUSTIN
+                    tableNormX = snapshot.plane.x;
+                    tableNormY = snapshot.plane.y;
+                    tableNormZ = snapshot.plane.z;
+                    tableIntercept = snapshot.plane.w;
+#endif
+#ifdef USE_CONTACT_PRIOR
+                    for (uint i=0; i<snapshot.contacts.size(); ++i) {
+                        *contactVars[i] = snapshot.contacts[i] != 0;
+                    }
+#endif
+                }
+            }
+            if (newSnapshot) {
+                itersUsed = snapshot.iterations;
+                stopReason = dart::IterationPolicy::stopReasonName(snapshot.stopReason);
+            }
+            if (newSnapshot && snapshot.optimized) {
+                infoLog.Log(snapshot.errObsToMod,snapshot.errObsToMod+snapshot.errModToObs,stabilityThreshold,resetInfoThreshold);
+            }
+
+            // parameters and pushed buttons for the next tracked frame
+            sampleFrameParameters(uiParams);
+            frameParameterHandover.publish(uiParams);
+
+            // mirror changed poses to the sliders at most at 30 Hz, and moved sliders to the poses
+            poseSliders.collectSliderChanges(sliderControlled);
+            poseSliders.flush(pangolin::Display("pose").IsShown(),1.0/30);
+
+            //////////////////////////////////////////////////////////////////////////////////////////////////////////
+            //                                                                                                      //
+            // Render this frame                                                                                    //
+            //                                                                                                      //
+            //////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+            // includes the buffer swap of FinishFrame()
+            dart::ScopedStageTimer renderTimer(stageTimers,stageRender);
+
+            glClearColor (1.0, 1.0, 1.0, 1.0);
+            glShadeModel (GL_SMOOTH);
+            float4 lightPosition = make_float4(normalize(make_float3(-0.4405,-0.5357,-0.619)),0);
+            glLightfv(GL_LIGHT0, GL_POSITION, (float*)&lightPosition);
 
+            camDisp.ActivateScissorAndClear(camState);
+
+            glEnable(GL_DEPTH_TEST);
+            glEnable(GL_LIGHT0);
+            glEnable(GL_NORMALIZE);
+            glEnable(GL_LIGHTING);
+
+            camDisp.ActivateAndScissor(camState);
+
+            glPushMatrix();
+#ifdef ENABLE_URDF
+            //static pangolin::Var<bool> showAxes("ui.showAxes",true,true);
+            static pangolin::Var<bool> showAxes("ui.showAxes",false,true);
+            if(showAxes) {
+                // draw coordinates axes, x: red, y: green, z: blue
+                pangolin::glDrawAxis(0.5);
+                glColor3f(0,0,1);
+                pangolin::glDraw_z0(0.01, 10);
+            }
+#endif
+
+            if (showCameraPose) {
+
+                glColor3f(0,0,0);
+                glPushMatrix();
+
+    //            glRotatef(180,0,1,0);
+    //            glutSolidCube(0.02);
+
+    //            glTranslatef(0,0,-0.02);
+    //            glutSolidCone(0.0125,0.02,10,1);
+
+                glPopMatrix();
+
+            }
+
+            glColor4ub(0xff,0xff,0xff,0xff);
+            if (showEstimatedPose) {
+
+                glEnable(GL_COLOR_MATERIAL);
+
+                glPushMatrix();
+
+                if (showVoxelized) {
+                    glColor3f(0.2,0.3,1.0);
+
+                    for (uint m=0; m<renderModels.size(); ++m) {
+    //                for (int m=1; m<=1; m+=10) {
+                        renderModels[m]->renderVoxels(levelSet);
+                    }
+                }
+                else{
+                    for (uint m=0; m<renderModels.size(); ++m) {
+                        renderModels[m]->render();
+                    }
+                }
+
+                glPopMatrix();
+
+            }
+
+            if (showReported) {
+                glColor3ub(0xfa,0x85,0x7c);
+                glEnable(GL_COLOR_MATERIAL);
+
+#ifdef ENABLE_JUSTIN
+                spaceJustinReported.renderWireframe();
+#endif
+
+#ifdef ENABLE_URDF
+                // render Valkyrie reported state as wireframe model, origin is the camera centre
+                val_reported.renderWireframe();
+#endif
+
+                // glColor3ub(0,0,0);
+                // glutSolidSphere(0.02,10,10);
+            }
+
+            glPointSize(1.0f);
+
+#ifdef JUSTIN
+            if (showTablePlane) {
+
+                float3 normal = normalize(make_float3(tableNormX,tableNormY,tableNormZ));
+                tableNormX = normal.x;
+                tableNormY = normal.y;
+                tableNormZ = normal.z;
+
+                float3 ipv1 = cross(normal,normal.x == 1 ? make_float3(0,1,0) : make_float3(1,0,0));
+                float3 ipv2 = cross(normal,ipv1);
+
+                float3 pts[4] = { operator+(operator *( 0.5,ipv1),operator *( 0.5,ipv2)),
+                                  operator+(operator *( 0.5,ipv1),operator *(-0.5,ipv2)),
+                                  operator+(operator *(-0.5,ipv1),operator *(-0.5,ipv2)),
+                                  operator+(operator *(-0.5,ipv1),operator *( 0.5,ipv2))};
+
+                glColor3ub(120,100,100);
+                glBegin(GL_QUADS);
+                glNormal3f(-normal.x,-normal.y,-normal.z);
+                for (int i=0; i<4; ++i) {
+                    glVertex3f(tableIntercept*normal.x + pts[i].x,
+                               tableIntercept*normal.y + pts[i].y,
+                               tableIntercept*normal.z + pts[i].z);
+                }
+                glEnd();
+
+            }
+#endif
+
+            if (showObsSdf) {
+                static pangolin::Var<float> levelSet("ui.levelSet",0,-10,10);
+
+                // the SDFs of the current snapshot, once the tracking thread copied them
+                for (uint m=0; m<snapshot.obsSdfs.size() && m<snapshot.modelTransforms.size(); ++m) {
+                    if (snapshot.obsSdfs[m].data.empty()) { continue; }
+
+                    glPushMatrix();
+                    dart::glMultSE3(snapshot.modelTransforms[m]);
+                    renderModels[m]->renderSdf(*obsSdfs[m],levelSet);
+                    glPopMatrix();
+                }
+            }
+
+            if (showTrackedPoints && !snapshot.obsVertMap.empty()) {
+
+                glPointSize(4.0f);
+
+                if (!snapshot.obsColors.empty()) {
+                    glDisable(GL_LIGHTING);
+                } else if (!snapshot.obsNormMap.empty()) {
+                    glColor3f(0.25,0.25,0.25);
+                }
+
+                // the snapshot only holds the colors or normals of the current point coloring
+                pointCloudStream->upload(snapshot.obsVertMap.data(),
+                                         snapshot.obsNormMap.empty() ? NULL : snapshot.obsNormMap.data(),
+                                         snapshot.obsColors.empty() ? NULL : snapshot.obsColors.data(),
+                                         snapshot.obsIndices,depthWidth*depthHeight);
+                pointCloudStream->draw();
+
+                glPointSize(1.0f);
+
+            }
+
+#ifdef USE_CONTACT_PRIOR
+            static pangolin::Var<bool> showFingerContacts("ui.showContacts",true,true);
+            if (showFingerContacts) {
+                glPointSize(10.f);
+                glBegin(GL_POINTS);
+                glColor3f(1.0,0,0);
+                for (uint i=0; i<snapshot.contactPoints.size(); ++i) {
+                    glVertex3fv(&snapshot.contactPoints[i].x);
+                }
+                glEnd();
+
+            }
+#endif
+
+            if (showPredictedPoints && !snapshot.predVertMap.empty()) {
+
+                if (newSnapshot) {
+                    if (!snapshot.predColors.empty()) {
+                        predictedPointBatch->buildColored(snapshot.predVertMap.data(),snapshot.predColors.data(),snapshot.predVertMap.size());
+                    } else {
+                        predictedPointBatch->buildLabelled(snapshot.predVertMap.data(),snapshot.predVertMap.size(),sdfColorTable);
+                    }
+                }
+
+                glPointSize(4.0f);
+                glDisable(GL_LIGHTING);
+                predictedPointBatch->draw();
+                glPointSize(1.0f);
+            }
+
+            if (showCollisionClouds) {
+                // frames of the rendered models
+                for (uint m=0; m<renderModels.size(); ++m) {
+                    dart::HostOnlyModel & model = *renderModels[m];
+                    collisionFrameToCamera[m].resize(model.getNumFrames());
+                    for (int f=0; f<model.getNumFrames(); ++f) {
+                        collisionFrameToCamera[m][f] = model.getTransformModelToCamera()*model.getTransformFrameToModel(f);
+                    }
+                    collisionCloudBatch->transform(m,collisionFrameToCamera[m]);
+                }
+
+                glPointSize(10);
+                glColor3f(0,0,1.0f);
+                glDisable(GL_LIGHTING);
+                collisionCloudBatch->draw();
+                glEnable(GL_LIGHTING);
+
+                glPointSize(1);
+                glColor3f(1,1,1);
+            }
+
+            glPopMatrix();
+
+            imgDisp.ActivateScissorAndClear();
+            glDisable(GL_LIGHTING);
+            glColor4ub(255,255,255,255);
+
+            if (!snapshot.depthImage.empty()) {
+                imgTexDepthSize.Upload(snapshot.depthImage.data(),GL_RGB,GL_UNSIGNED_BYTE);
+                if (snapshot.flipDepthImage) {
+                    imgTexDepthSize.RenderToViewportFlipY();
+                } else {
+                    imgTexDepthSize.RenderToViewport();
+                }
+            }
+            if (!snapshot.predImage.empty()) {
+                imgTexPredictionSize.Upload(snapshot.predImage.data(),GL_RGB,GL_UNSIGNED_BYTE);
+                imgTexPredictionSize.RenderToViewport();
+            }
+
+            dart::backend::checkLastError();
+
+            if(pangolin::Pushed(record)) {
+                    pangolin::DisplayBase().RecordOnRender("ffmpeg:[fps=50,bps=8388608,unique_filename]//screencap.avi");
+            }
+
+            pangolin::FinishFrame();
+        }
+
+        stopTracking = true;
+        trackingThread.join();
+    }
+
+    if (headless) {
+        // until the last tracked frame, i.e. without the input timeout at the end of a stream
+        const double totalTime = pangolin::TimeDiff_s(headlessStart,headlessFrameStart);
+        std::cout << "headless throughput (" << dart::backend::name() << "): "
+                  << headlessFrames << " frames in " << totalTime << " s, "
+                  << headlessFrames/totalTime << " fps, "
+                  << "mean " << 1000*totalTime/std::max(headlessFrames,1) << " ms/frame, "
+                  << "max " << 1000*headlessMaxFrameTime << " ms/frame" << std::endl;
+        stageTimers.dump(std::cout);
+    }
+
+    if (iterationFrames > 0) {
+        std::cout << "iterations: mean " << double(iterationSum)/iterationFrames << " per frame, stopped by";
+        for (int r=0; r<dart::IterationPolicy::NumStopReasons; ++r) {
+            std::cout << (r ? ", " : " ") << dart::IterationPolicy::stopReasonName(dart::IterationPolicy::StopReason(r)) << " " << stopReasonCounts[r];
+        }
+        std::cout << std::endl;
+    }
+
+    std::cout << "frame arena: host peak " << frameArena.hostPeak() << " of " << frameArena.hostCapacity() << " bytes, "
+              << "device peak " << frameArena.devicePeak() << " of " << frameArena.deviceCapacity() << " bytes, "
+              << frameArena.overflows() << " overflows" << std::endl;
+
+    // a replay with an undelivered frame did not track the whole log and must not be reported as a run
+    bool replayFailed = false;
+#ifdef DEPTH_SOURCE_LCM
+    if (replay && replay->failed()) {
+        std::cerr << "replay stopped after " << replay->frames() << " frames, frame was not delivered" << std::endl;
+        replayFailed = true;
+    }
+#endif
+
+    if (!reportFile.empty() && !replayFailed) {
+        dart::TrackerConfig report;
+        report.params = params;
+        report.params.itersPerFrame = itersPerFrame;
+        report.params.distanceThreshold = distanceThreshold;
+        report.params.infoAccumulationRate = infoAccumulationRate;
+        report.params.minUpdateNorm = minUpdateNorm;
+        report.params.minErrorChange = minErrorChange;
+        report.params.frameBudget = frameBudget;
+        if (iterationFrames > 0) {
+            report.iterationsMean = double(iterationSum)/iterationFrames;
+        }
+        report.frames = frameLatencies.size();
+        if (!frameLatencies.empty()) {
+            double latencySum = 0;
+            for (const float l : frameLatencies) { latencySum += l; }
+            report.latencyMean = latencySum/frameLatencies.size();
+            std::vector<float>::iterator p95 = frameLatencies.begin() + (frameLatencies.size()*95)/100;
+            std::nth_element(frameLatencies.begin(), p95, frameLatencies.end());
+            report.latencyP95 = *p95;
+        }
+        if (jointErrorFrames > 0) {
+            report.jointError = jointErrorSum/jointErrorFrames;
+        }
+        dart::saveTrackerConfigs(reportFile,std::vector<dart::TrackerConfig>(1,report),
+                                 std::string("track_manipulation report, backend ")+dart::backend::name());
     }
 
-    glDeleteBuffersARB(1,&pointCloudVbo);
-    glDeleteBuffersARB(1,&pointCloudColorVbo);
-    glDeleteBuffersARB(1,&pointCloudNormVbo);
+    pointCloudStream.reset();
+    predictedPointBatch.reset();
+    collisionCloudBatch.reset();
 
     for (int m=0; m<tracker.getNumModels(); ++m) {
         for (int i=0; i<tracker.getPose(m).getReducedDimensions(); ++i) {
@@ -1705,5 +2496,5 @@ int main(int argc, char *argv[]) {
 
     delete depthSource;
 
-    return 0;
+    return replayFailed ? 1 : 0;
 }